@@ -3,7 +3,10 @@
 #include <vector>
 #include <string>
 #include <sstream>
+#include <fstream>
+#include <functional>
 #include <cstdio>
+#include <cstring>
 #include <iostream>
 #include "src/main.hxx"
 
@@ -16,309 +19,665 @@ using namespace std;
 #ifndef TYPE
 #define TYPE float
 #endif
-// You can define number of threads with -DMAX_THREADS=...
+// You can define default number of threads with -DMAX_THREADS=...
+// (or choose them at runtime with --threads).
 #ifndef MAX_THREADS
 #define MAX_THREADS 12
 #endif
 
+using Key   = int;
+using Rank  = TYPE;
+using OutGraph = OutDiGraph<Key>;
+using InGraph = decltype(transposeWithDegree(OutGraph()));
 
 
 
-void runPagerankBatch(const string& data, size_t batch, size_t skip, int repeat) {
-  using K = int;
-  using T = TYPE;
+
+// OPTIONS
+// -------
+
+struct Options {
+  string file;                  // temporal edges (text, or binary snapshot)
+  string snapshot;              // write binary snapshot to (optional)
+  string format = "log";        // log, csv, json (lines)
+  string output;                // write records to (default stdout)
+  vector<string> algorithms;    // algorithms to run (default all)
+  vector<size_t> batches;       // batch sizes
+  vector<int>    threads;       // thread counts
+  int  repeat = 5;              // times to repeat each algorithm
+  int  steps  = 10;             // batches per batch size
+  bool perf   = false;          // read hardware counters?
+  bool list   = false;          // list algorithms?
+  bool check  = false;          // run self-checks upon graph?
+  bool help   = false;
+  // Streaming service (--serve).
+  bool   serve  = false;          // read batches from stdin (or socket)?
+  string socket;                  // Unix socket to serve on (optional)
+  size_t batchSize  = 1000;       // edges per batch
+  float  batchDelay = 0;          // close batch after (ms, 0 = never)
+  int    prepareThreads = 1;      // threads for preparing next batch
+};
+
+
+template <class T>
+vector<T> parseList(const string& s) {
+  vector<T> a; string t;
+  istringstream in(s);
+  while (getline(in, t, ',')) {
+    if (t.empty()) continue;
+    T v; istringstream(t) >> v;
+    a.push_back(v);
+  }
+  return a;
+}
+
+template <>
+vector<size_t> parseList<size_t>(const string& s) {
+  vector<size_t> a;
+  for (auto v : parseList<double>(s))
+    a.push_back(size_t(v));  // allow 1e3
+  return a;
+}
+
+
+// Usage: main <file> [repeat] [snapshot] [--option value ...]
+bool parseOptions(Options& o, int argc, char **argv) {
+  vector<string> ps;
+  for (int i=1; i<argc; ++i) {
+    string k = argv[i];
+    auto val = [&]() { return i+1<argc? string(argv[++i]) : string(); };
+    if      (k=="-h" || k=="--help") o.help = true;
+    else if (k=="--list")       o.list = true;
+    else if (k=="--check")      o.check = true;
+    else if (k=="--perf")       o.perf = true;
+    else if (k=="--format")     o.format = val();
+    else if (k=="--output")     o.output = val();
+    else if (k=="--snapshot")   o.snapshot = val();
+    else if (k=="--algorithms") o.algorithms = parseList<string>(val());
+    else if (k=="--batches")    o.batches = parseList<size_t>(val());
+    else if (k=="--threads")    o.threads = parseList<int>(val());
+    else if (k=="--repeat")     o.repeat = stoi(val());
+    else if (k=="--steps")      o.steps  = stoi(val());
+    else if (k=="--serve")      o.serve  = true;
+    else if (k=="--socket")     o.socket = val();
+    else if (k=="--batch-size")  o.batchSize  = size_t(stod(val()));
+    else if (k=="--batch-delay") o.batchDelay = stof(val());
+    else if (k=="--prepare-threads") o.prepareThreads = stoi(val());
+    else if (k.rfind("--", 0)==0) { fprintf(stderr, "Unknown option %s\n", k.c_str()); return false; }
+    else ps.push_back(k);
+  }
+  if (ps.size()>0) o.file     = ps[0];
+  if (ps.size()>1) o.repeat   = stoi(ps[1]);
+  if (ps.size()>2) o.snapshot = ps[2];
+  if (o.batches.empty()) o.batches = {100, 1000, 10000, 100000, 1000000};
+  if (o.threads.empty()) o.threads = {MAX_THREADS};
+  if (o.format!="log" && o.format!="csv" && o.format!="json") { fprintf(stderr, "Unknown format %s\n", o.format.c_str()); return false; }
+  return o.help || o.list || o.serve || !o.file.empty();
+}
+
+
+void printUsage(const char *name) {
+  printf("Usage: %s <file> [repeat] [snapshot] [options]\n", name);
+  printf("  --algorithms a,b,...  algorithms to run (default all, see --list)\n");
+  printf("  --batches 1e2,1e3,... batch sizes\n");
+  printf("  --threads 1,2,4,...   thread counts (default %d)\n", MAX_THREADS);
+  printf("  --repeat N            times to repeat each algorithm (default 5)\n");
+  printf("  --steps N             batches per batch size (default 10)\n");
+  printf("  --format log|csv|json output format (json is one object per line)\n");
+  printf("  --output FILE         write output to file (default stdout)\n");
+  printf("  --perf                read hardware counters (perf_event_open)\n");
+  printf("  --snapshot FILE       write binary snapshot of temporal edges\n");
+  printf("  --list                list algorithms\n");
+  printf("  --check               run self-checks upon graph (exit status 1 on failure)\n");
+  printf("\nUsage: %s --serve [file] [options]\n", name);
+  printf("  --socket PATH         serve on Unix socket (default stdin/stdout)\n");
+  printf("  --batch-size N        edges per batch (default 1000)\n");
+  printf("  --batch-delay MS      close batch after its first edge waits (default never)\n");
+  printf("  --prepare-threads N   threads preparing next batch (default 1)\n");
+  printf("  --threads N           threads computing ranks\n");
+  printf("Lines: \"u v [t]\", \"- u v\", \"commit\", \"rank u\", \"top k\", \"stats\", \"wait v\", \"end\".\n");
+}
+
+
+
+
+// ALGORITHMS
+// ----------
+// Each algorithm is run upon every batch, with the graph before (x) and
+// after (y) the batch update. The harness updates the graph in place (x = y),
+// so what dynamic algorithms need of the graph before (vertices, dead ends,
+// and changed vertices) is given with Pagerank data (C).
+
+struct BatchContext {
+  const OutGraph& x;
+  const InGraph& xt;
+  const OutGraph& y;
+  const InGraph& yt;
+  const vector<Rank> *initStatic;   // no initial ranks
+  const vector<Rank> *initDynamic;  // ranks adjusted from previous graph
+  const PagerankData<OutGraph> *C;
+  PagerankOptions<Rank> options;
+
+  // Options with/without splitting components, and a vertex order.
+  PagerankOptions<Rank> with(bool split, int reorder=ORDER_NATURAL) const {
+    auto o = options;
+    o.splitComponents = split;
+    o.reorder = reorder;
+    return o;
+  }
+};
+
+
+struct PagerankAlgorithm {
+  const char *name;
+  const char *kind;  // static, naive-dynamic, dynamic
+  function<PagerankResult<Rank>(const BatchContext&)> run;
+  double minTolerance = 0;  // below this, error is bounded by rank storage instead
+};
+
+
+#define PAGERANK_STATIC(name, call)        {name, "static",        [](const BatchContext& b) { return call(b.y, b.yt, b.initStatic, OPTS, b.C); }}
+#define PAGERANK_NAIVE_DYNAMIC(name, call) {name, "naive-dynamic", [](const BatchContext& b) { return call(b.y, b.yt, b.initDynamic, OPTS, b.C); }}
+#define PAGERANK_DYNAMIC(name, call)       {name, "dynamic",       [](const BatchContext& b) { return call(b.x, b.xt, b.y, b.yt, b.initDynamic, OPTS, b.C); }}
+
+const vector<PagerankAlgorithm>& pagerankAlgorithms() {
+  #define OPTS b.with(false)
+  static const vector<PagerankAlgorithm> a0 = {
+    PAGERANK_STATIC("pagerankOmpUnorderedStatic",      (pagerankMonolithicOmp<false, true>)),
+    PAGERANK_STATIC("pagerankOmpOrderedStatic",        (pagerankMonolithicOmp<true, true>)),
+    PAGERANK_STATIC("pagerankBarrierfreeFullStatic",   (pagerankMonolithicBarrierfreeOmp<true, true, true>)),
+    PAGERANK_STATIC("pagerankBarrierfreePartStatic",   (pagerankMonolithicBarrierfreeOmp<true, true, false>)),
+    PAGERANK_STATIC("pagerankStealingStatic",          (pagerankMonolithicStealingOmp<true>)),
+    PAGERANK_STATIC("pagerankFrontierStatic",          (pagerankMonolithicFrontierOmp<true>)),
+    PAGERANK_STATIC("pagerankSimdFloatStatic",         (pagerankMonolithicSimdOmp<true, float>)),
+    {"pagerankSimdBfloat16Static", "static", [](const BatchContext& b) { return pagerankMonolithicSimdOmp<true, Bfloat16>(b.y, b.yt, b.initStatic, OPTS, b.C); }, pagerankStorageTolerance<Bfloat16>()},
+    PAGERANK_NAIVE_DYNAMIC("pagerankOmpUnorderedNaiveDynamic",    (pagerankMonolithicOmp<false, true>)),
+    PAGERANK_NAIVE_DYNAMIC("pagerankOmpOrderedNaiveDynamic",      (pagerankMonolithicOmp<true, true>)),
+    PAGERANK_NAIVE_DYNAMIC("pagerankBarrierfreeFullNaiveDynamic", (pagerankMonolithicBarrierfreeOmp<true, true, true>)),
+    PAGERANK_NAIVE_DYNAMIC("pagerankBarrierfreePartNaiveDynamic", (pagerankMonolithicBarrierfreeOmp<true, true, false>)),
+    PAGERANK_NAIVE_DYNAMIC("pagerankStealingNaiveDynamic",        (pagerankMonolithicStealingOmp<true>)),
+    PAGERANK_NAIVE_DYNAMIC("pagerankFrontierNaiveDynamic",        (pagerankMonolithicFrontierOmp<true>)),
+    PAGERANK_NAIVE_DYNAMIC("pagerankSimdFloatNaiveDynamic",       (pagerankMonolithicSimdOmp<true, float>)),
+    PAGERANK_DYNAMIC("pagerankOmpUnorderedDynamic",    (pagerankMonolithicOmpDynamic<false, true>)),
+    PAGERANK_DYNAMIC("pagerankOmpOrderedDynamic",      (pagerankMonolithicOmpDynamic<true, true>)),
+    PAGERANK_DYNAMIC("pagerankBarrierfreeFullDynamic", (pagerankMonolithicBarrierfreeOmpDynamic<true, true, true>)),
+    PAGERANK_DYNAMIC("pagerankBarrierfreePartDynamic", (pagerankMonolithicBarrierfreeOmpDynamic<true, true, false>)),
+    PAGERANK_DYNAMIC("pagerankStealingDynamic",        (pagerankMonolithicStealingOmpDynamic<true>)),
+    PAGERANK_DYNAMIC("pagerankFrontierDynamic",        (pagerankMonolithicFrontierOmpDynamic<true>)),
+    PAGERANK_DYNAMIC("pagerankSimdFloatDynamic",       (pagerankMonolithicSimdOmpDynamic<true, float>)),
+  };
+  #undef  OPTS
+  #define OPTS b.with(true)
+  static const vector<PagerankAlgorithm> a1 = {
+    PAGERANK_STATIC("pagerankOmpUnorderedMonolithicStatic",      (pagerankMonolithicOmp<false, true>)),
+    PAGERANK_STATIC("pagerankOmpUnorderedLevelwiseStatic",       (pagerankLevelwiseOmp<false, true>)),
+    PAGERANK_STATIC("pagerankOmpOrderedMonolithicStatic",        (pagerankMonolithicOmp<true, true>)),
+    PAGERANK_STATIC("pagerankOmpOrderedLevelwiseStatic",         (pagerankLevelwiseOmp<true, true>)),
+    PAGERANK_STATIC("pagerankBarrierfreeFullMonolithicStatic",   (pagerankMonolithicBarrierfreeOmp<true, true, true>)),
+    PAGERANK_STATIC("pagerankBarrierfreeFullLevelwiseStatic",    (pagerankLevelwiseBarrierfreeOmp<true, true, true>)),
+    PAGERANK_STATIC("pagerankBarrierfreePartMonolithicStatic",   (pagerankMonolithicBarrierfreeOmp<true, true, false>)),
+    PAGERANK_STATIC("pagerankBarrierfreePartLevelwiseStatic",    (pagerankLevelwiseBarrierfreeOmp<true, true, false>)),
+    PAGERANK_NAIVE_DYNAMIC("pagerankOmpUnorderedMonolithicNaiveDynamic",    (pagerankMonolithicOmp<false, true>)),
+    PAGERANK_NAIVE_DYNAMIC("pagerankOmpUnorderedLevelwiseNaiveDynamic",     (pagerankLevelwiseOmp<false, true>)),
+    PAGERANK_NAIVE_DYNAMIC("pagerankOmpOrderedMonolithicNaiveDynamic",      (pagerankMonolithicOmp<true, true>)),
+    PAGERANK_NAIVE_DYNAMIC("pagerankOmpOrderedLevelwiseNaiveDynamic",       (pagerankLevelwiseOmp<true, true>)),
+    PAGERANK_NAIVE_DYNAMIC("pagerankBarrierfreeFullMonolithicNaiveDynamic", (pagerankMonolithicBarrierfreeOmp<true, true, true>)),
+    PAGERANK_NAIVE_DYNAMIC("pagerankBarrierfreeFullLevelwiseNaiveDynamic",  (pagerankLevelwiseBarrierfreeOmp<true, true, true>)),
+    PAGERANK_NAIVE_DYNAMIC("pagerankBarrierfreePartMonolithicNaiveDynamic", (pagerankMonolithicBarrierfreeOmp<true, true, false>)),
+    PAGERANK_NAIVE_DYNAMIC("pagerankBarrierfreePartLevelwiseNaiveDynamic",  (pagerankLevelwiseBarrierfreeOmp<true, true, false>)),
+    PAGERANK_DYNAMIC("pagerankOmpUnorderedMonolithicDynamic",    (pagerankMonolithicOmpDynamic<false, true>)),
+    PAGERANK_DYNAMIC("pagerankOmpUnorderedLevelwiseDynamic",     (pagerankLevelwiseOmpDynamic<false, true>)),
+    PAGERANK_DYNAMIC("pagerankOmpOrderedMonolithicDynamic",      (pagerankMonolithicOmpDynamic<true, true>)),
+    PAGERANK_DYNAMIC("pagerankOmpOrderedLevelwiseDynamic",       (pagerankLevelwiseOmpDynamic<true, true>)),
+    PAGERANK_DYNAMIC("pagerankBarrierfreeFullMonolithicDynamic", (pagerankMonolithicBarrierfreeOmpDynamic<true, true, true>)),
+    PAGERANK_DYNAMIC("pagerankBarrierfreeFullLevelwiseDynamic",  (pagerankLevelwiseBarrierfreeOmpDynamic<true, true, true>)),
+    PAGERANK_DYNAMIC("pagerankBarrierfreePartMonolithicDynamic", (pagerankMonolithicBarrierfreeOmpDynamic<true, true, false>)),
+    PAGERANK_DYNAMIC("pagerankBarrierfreePartLevelwiseDynamic",  (pagerankLevelwiseBarrierfreeOmpDynamic<true, true, false>)),
+  };
+  #undef  OPTS
+  static const vector<PagerankAlgorithm> a2 = {
+    {"pagerankOmpOrderedDegreeStatic", "static", [](const BatchContext& b) { return pagerankMonolithicOmp<true, true>(b.y, b.yt, b.initStatic, b.with(false, ORDER_DEGREE), b.C); }},
+    {"pagerankOmpOrderedRcmStatic",    "static", [](const BatchContext& b) { return pagerankMonolithicOmp<true, true>(b.y, b.yt, b.initStatic, b.with(false, ORDER_RCM), b.C); }},
+    {"pagerankOmpOrderedHubStatic",    "static", [](const BatchContext& b) { return pagerankMonolithicOmp<true, true>(b.y, b.yt, b.initStatic, b.with(false, ORDER_HUB), b.C); }},
+    {"pagerankOmpOrderedLevelwiseRcmStatic", "static", [](const BatchContext& b) { return pagerankLevelwiseOmp<true, true>(b.y, b.yt, b.initStatic, b.with(true, ORDER_RCM), b.C); }},
+  };
+  static vector<PagerankAlgorithm> a;
+  if (a.empty()) {
+    const char *kinds[] = {"static", "naive-dynamic", "dynamic"};
+    for (auto k : kinds) {
+      for (const auto& g : {&a0, &a1, &a2})
+        for (const auto& r : *g)
+          if (strcmp(r.kind, k)==0) a.push_back(r);
+    }
+  }
+  return a;
+}
+
+#undef PAGERANK_STATIC
+#undef PAGERANK_NAIVE_DYNAMIC
+#undef PAGERANK_DYNAMIC
+
+
+bool hasAlgorithm(const Options& o, const char *name) {
+  if (o.algorithms.empty()) return true;
+  for (const auto& a : o.algorithms)
+    if (a==name || a=="all") return true;
+  return false;
+}
+
+
+
+
+// RECORDS
+// -------
+// Each record is either a pipeline phase, or an algorithm run on a batch.
+
+struct BenchmarkRecord {
+  string graph;
+  int    threads   = 0;
+  size_t batchSize = 0;
+  int    batch     = 0;
+  size_t order     = 0;
+  size_t size      = 0;
+  string kind;        // phase, static, naive-dynamic, dynamic
+  string name;
+  string note;        // caveat upon the result, if any
+  float  time  = 0;   // time of phase, or of iterations (ms, per repeat)
+  float  setup = 0;   // time outside iterations, e.g. CSR build (ms, per repeat)
+  int    iterations = 0;
+  double error = 0;
+  PagerankThreadWork work;
+  PerfCounts counts;
+};
+
+
+class BenchmarkWriter {
+  // Data.
+  protected:
+  FILE  *out;
+  string format;
+  bool   header = false;
+
+
+  // Write operations.
+  protected:
+  void writeList(const vector<float>& xs, const char *sep, const char *fmt="%.3f") {
+    for (size_t i=0; i<xs.size(); ++i) {
+      if (i) fprintf(out, "%s", sep);
+      fprintf(out, fmt, xs[i]);
+    }
+  }
+
+  void writeLog(const BenchmarkRecord& r) {
+    if (r.kind=="phase") { fprintf(out, "- phase-%s: %.3f ms\n", r.name.c_str(), r.time); return; }
+    fprintf(out, "[%zu order; %zu size; %09.3f ms; %03d iters.] [%.4e err.] %s", r.order, r.size, r.time, r.iterations, r.error, r.name.c_str());
+    fprintf(out, r.note.empty()? "\n" : " (%s)\n", r.note.c_str());
+    if (!r.work.iterations.empty()) {
+      fprintf(out, "- thread-iterations: "); writeList(r.work.iterations, " ", "%.1f");
+      fprintf(out, "\n- thread-idle-time: ");  writeList(r.work.idleTime, " ");
+      fprintf(out, "\n");
+    }
+    if (r.counts.valid) fprintf(out, "- perf: %llu cycles; %llu instructions; %llu cache-misses; %llu branch-misses\n",
+      (unsigned long long) r.counts.cycles, (unsigned long long) r.counts.instructions, (unsigned long long) r.counts.cacheMisses, (unsigned long long) r.counts.branchMisses);
+  }
+
+  void writeCsv(const BenchmarkRecord& r) {
+    if (!header) fprintf(out, "graph,threads,batch_size,batch,order,size,kind,name,time,setup,iterations,error,thread_iterations,thread_idle_time,cycles,instructions,cache_misses,branch_misses\n");
+    header = true;
+    fprintf(out, "\"%s\",%d,%zu,%d,%zu,%zu,%s,%s,%.3f,%.3f,%d,%.4e,\"", r.graph.c_str(), r.threads, r.batchSize, r.batch, r.order, r.size, r.kind.c_str(), r.name.c_str(), r.time, r.setup, r.iterations, r.error);
+    writeList(r.work.iterations, " "); fprintf(out, "\",\"");
+    writeList(r.work.idleTime, " ");   fprintf(out, "\",");
+    if (r.counts.valid) fprintf(out, "%llu,%llu,%llu,%llu\n", (unsigned long long) r.counts.cycles, (unsigned long long) r.counts.instructions, (unsigned long long) r.counts.cacheMisses, (unsigned long long) r.counts.branchMisses);
+    else fprintf(out, ",,,\n");
+  }
+
+  void writeJson(const BenchmarkRecord& r) {
+    fprintf(out, "{\"graph\":\"%s\",\"threads\":%d,\"batch_size\":%zu,\"batch\":%d,\"order\":%zu,\"size\":%zu,\"kind\":\"%s\",\"name\":\"%s\",\"time\":%.3f,\"setup\":%.3f,\"iterations\":%d,\"error\":%.4e",
+      r.graph.c_str(), r.threads, r.batchSize, r.batch, r.order, r.size, r.kind.c_str(), r.name.c_str(), r.time, r.setup, r.iterations, r.error);
+    fprintf(out, ",\"thread_iterations\":["); writeList(r.work.iterations, ",");
+    fprintf(out, "],\"thread_idle_time\":[");  writeList(r.work.idleTime, ",");
+    fprintf(out, "]");
+    if (r.counts.valid) fprintf(out, ",\"cycles\":%llu,\"instructions\":%llu,\"cache_misses\":%llu,\"branch_misses\":%llu",
+      (unsigned long long) r.counts.cycles, (unsigned long long) r.counts.instructions, (unsigned long long) r.counts.cacheMisses, (unsigned long long) r.counts.branchMisses);
+    fprintf(out, "}\n");
+  }
+
+
+  // Public operations.
+  public:
+  inline bool isLog() const noexcept { return format=="log"; }
+
+  // Log lines are free-form (for process.js), only for log format.
+  template <class... A>
+  void log(const char *fmt, A... args) {
+    if (isLog()) fprintf(out, fmt, args...);
+  }
+
+  void write(const BenchmarkRecord& r) {
+    if (format=="csv")       writeCsv(r);
+    else if (format=="json") writeJson(r);
+    else writeLog(r);
+    fflush(out);
+  }
+
+  BenchmarkWriter(FILE *out, const string& format) :
+  out(out), format(format) {}
+};
+
+
+
+
+// BENCHMARK
+// ---------
+
+// Reference ranks are found in double precision, as float ones lose some
+// rank mass to rounding (about 1e-4 in L1-norm), which would hide the error
+// of engines that normalize ranks.
+template <class G, class H>
+vector<Rank> referenceRanks(const G& x, const H& xt, double damping) {
+  enum NormFunction { L0=0, L1=1, L2=2, Li=3 };
+  auto a = pagerankMonolithicSeq<false, true>(x, xt, (const vector<double>*) nullptr, {1, false, damping, Li, 1e-12});
+  return vector<Rank>(a.ranks.begin(), a.ranks.end());
+}
+
+
+void runPagerankBatch(BenchmarkWriter& w, PerfCounters& pc, const Options& opt, const string& graph, const SnapTemporalEdges<>& data, size_t batch, size_t skip) {
+  using K = Key;
+  using T = Rank;
+  using G = OutGraph;
   enum NormFunction { L0=0, L1=1, L2=2, Li=3 };
   vector<T> ranksOld, ranksAdj;
   vector<T> *initStatic  = nullptr;
   vector<T> *initDynamic = &ranksAdj;
-  auto fl = [](auto u) { return true; };
   float damping   = 0.85;
   float tolerance = 1e-8;
+  int   repeat    = opt.repeat;
+  int   b = 0;       // batch number
 
-  OutDiGraph<K> xo;
-  stringstream  stream(data);
+  G  x;              // updated in place
+  auto xt = transposeWithDegree(x);
+  SlackCsr<K>   R;   // persistent CSR of (yt), patched with new edges
+  DynamicComponents<G> S;  // components of (y), updated with batches
+  vector<pair<K, K>> del, ins, es;
+  size_t i = 0;       // next temporal edge to read
+  auto readBatch = [&](size_t N) {
+    size_t I = min(i+N, data.size());
+    bool  ok = N==0 || i<I;
+    ins.clear();
+    for (; i<I; ++i) {
+      K u = data.sources[i], v = data.targets[i];
+      ins.push_back({u, v});
+    }
+    return ok;
+  };
+  auto applyBatch = [&](auto& a, auto& at) {
+    auto ks = applyBatchU(a, at, del, ins);
+    es.insert(es.end(), ins.begin(), ins.end());
+    return ks;
+  };
+  auto updateComponents = [&](auto& a, auto& at) {
+    if (S.size()>0) S.update(a, at, del, ins);
+  };
+  auto patchCsr = [&](const auto& yt) {
+    if (R.order()==0) { R.assignFrom(yt, yt.vertexKeys()); es.clear(); return; }
+    for (auto [u, v] : es)
+      R.addEdge(u, v);
+    es.clear();
+  };
+  BenchmarkRecord r0;
+  r0.graph = graph; r0.threads = omp_get_max_threads(); r0.batchSize = batch;
+  auto phase = [&](const G& y, const char *name, auto fn) {
+    BenchmarkRecord r = r0;
+    r.batch = b; r.order = y.order(); r.size = y.size();
+    r.kind  = "phase"; r.name = name;
+    r.time  = measureDuration(fn);
+    w.write(r);
+  };
   while (true) {
     // Lets skip some edges.
-    if (!readSnapTemporalW(xo, stream, skip)) break;
-    auto x  = selfLoop(xo, None(), fl);
-    auto xt = transposeWithDegree(x);
+    if (!readBatch(skip)) break;
+    applyBatch(x, xt);
+    updateComponents(x, xt);
     auto a0 = pagerankMonolithicSeq<false, true>(x, xt, initStatic, {1, false, damping, Li, tolerance});
     auto ksOld = vertexKeys(x);
+    auto dsOld = deadEnds(x);
     ranksOld   = a0.ranks;
 
-    // Read batch to be processed.
-    auto yo = duplicate(xo);
-    if (!readSnapTemporalW(yo, stream, batch)) break;
-    auto y  = selfLoop(yo, None(), fl);
-    auto yt = transposeWithDegree(y);
-    auto a1 = pagerankMonolithicSeq<false, true>(y, yt, initStatic, {1, false, damping, Li, tolerance});
-    auto ks = vertexKeys(y);
+    // Read batch to be processed, and apply it in place (y = x).
+    auto& y = x; auto& yt = xt; bool ok = true;
+    vector<K> kc, ks;
+    phase(x, "read-batch",  [&]() { ok = readBatch(batch); });
+    if (!ok) break;
+    phase(y, "apply-batch", [&]() { kc = applyBatch(y, yt); ks = vertexKeys(y); });
+    phase(y, "update-components", [&]() { if (S.size()==0) S.assignFrom(y, yt); else updateComponents(y, yt); });
+    phase(y, "patch-csr",   [&]() { patchCsr(yt); });
 
     // Find Pagerank data.
-    using G = decltype(y);
-    auto cs = components(y, yt);
-    auto b  = blockgraph(y, cs);
-    auto bt = transpose(b);
-    auto gs = levelwiseComponentsFrom(cs, b, bt);
-    printf("- components: %zu\n", cs.size());
-    printf("- blockgraph-levels: %d\n", gs.size());
-    PagerankData<G> C {move(cs), move(b), move(bt)};
-
-    do {
-      do {
-        // Find pagerank accelerated with OpenMP (static, unordered, no dead ends).
-        auto a2 = pagerankMonolithicOmp<false, false>(y, yt, initStatic, {repeat, false, damping, Li, tolerance}, &C);
-        auto e2 = l1Norm(a2.ranks, a1.ranks);
-        printf("[%zu order; %zu size; %09.3f ms; %03d iters.] [%.4e err.] pagerankOmpUnorderedStatic\n", y.order(), y.size(), a2.time, a2.iterations, e2);
-      } while (0);
-      do {
-        // Find pagerank accelerated with OpenMP (static, unordered, no dead ends, monolithic).
-        auto a2 = pagerankMonolithicOmp<false, false>(y, yt, initStatic, {repeat, true, damping, Li, tolerance}, &C);
-        auto e2 = l1Norm(a2.ranks, a1.ranks);
-        printf("[%zu order; %zu size; %09.3f ms; %03d iters.] [%.4e err.] pagerankOmpUnorderedMonolithicStatic\n", y.order(), y.size(), a2.time, a2.iterations, e2);
-      } while (0);
-      do {
-        // Find pagerank accelerated with OpenMP (static, unordered, no dead ends, levelwise).
-        auto a2 = pagerankLevelwiseOmp<false, false>(y, yt, initStatic, {repeat, true, damping, Li, tolerance}, &C);
-        auto e2 = l1Norm(a2.ranks, a1.ranks);
-        printf("[%zu order; %zu size; %09.3f ms; %03d iters.] [%.4e err.] pagerankOmpUnorderedLevelwiseStatic\n", y.order(), y.size(), a2.time, a2.iterations, e2);
-      } while (0);
-      do {
-        // Find pagerank accelerated with OpenMP (static, ordered, no dead ends).
-        auto a2 = pagerankMonolithicOmp<true, false>(y, yt, initStatic, {repeat, false, damping, Li, tolerance}, &C);
-        auto e2 = l1Norm(a2.ranks, a1.ranks);
-        printf("[%zu order; %zu size; %09.3f ms; %03d iters.] [%.4e err.] pagerankOmpOrderedStatic\n", y.order(), y.size(), a2.time, a2.iterations, e2);
-      } while (0);
-      do {
-        // Find pagerank accelerated with OpenMP (static, ordered, no dead ends, monolithic).
-        auto a2 = pagerankMonolithicOmp<true, false>(y, yt, initStatic, {repeat, true, damping, Li, tolerance}, &C);
-        auto e2 = l1Norm(a2.ranks, a1.ranks);
-        printf("[%zu order; %zu size; %09.3f ms; %03d iters.] [%.4e err.] pagerankOmpOrderedMonolithicStatic\n", y.order(), y.size(), a2.time, a2.iterations, e2);
-      } while (0);
-      do {
-        // Find pagerank accelerated with OpenMP (static, ordered, no dead ends, levelwise).
-        auto a2 = pagerankLevelwiseOmp<true, false>(y, yt, initStatic, {repeat, true, damping, Li, tolerance}, &C);
-        auto e2 = l1Norm(a2.ranks, a1.ranks);
-        printf("[%zu order; %zu size; %09.3f ms; %03d iters.] [%.4e err.] pagerankOmpOrderedLevelwiseStatic\n", y.order(), y.size(), a2.time, a2.iterations, e2);
-      } while (0);
-      do {
-        // Find pagerank with barrier-free iterations accelerated with OpenMP (static, ordered, no dead ends, full error).
-        auto a2 = pagerankMonolithicBarrierfreeOmp<true, false, true>(y, yt, initStatic, {repeat, false, damping, Li, tolerance}, &C);
-        auto e2 = l1Norm(a2.ranks, a1.ranks);
-        printf("[%zu order; %zu size; %09.3f ms; %03d iters.] [%.4e err.] pagerankBarrierfreeFullStatic\n", y.order(), y.size(), a2.time, a2.iterations, e2);
-      } while (0);
-      do {
-        // Find pagerank with barrier-free iterations accelerated with OpenMP (static, ordered, no dead ends, full error, monolithic).
-        auto a2 = pagerankMonolithicBarrierfreeOmp<true, false, true>(y, yt, initStatic, {repeat, true, damping, Li, tolerance}, &C);
-        auto e2 = l1Norm(a2.ranks, a1.ranks);
-        printf("[%zu order; %zu size; %09.3f ms; %03d iters.] [%.4e err.] pagerankBarrierfreeFullMonolithicStatic\n", y.order(), y.size(), a2.time, a2.iterations, e2);
-      } while (0);
-      do {
-        // Find pagerank with barrier-free iterations accelerated with OpenMP (static, ordered, no dead ends, full error, levelwise).
-        auto a2 = pagerankLevelwiseBarrierfreeOmp<true, false, true>(y, yt, initStatic, {repeat, true, damping, Li, tolerance}, &C);
-        auto e2 = l1Norm(a2.ranks, a1.ranks);
-        printf("[%zu order; %zu size; %09.3f ms; %03d iters.] [%.4e err.] pagerankBarrierfreeFullLevelwiseStatic\n", y.order(), y.size(), a2.time, a2.iterations, e2);
-      } while (0);
-      do {
-        // Find pagerank with barrier-free iterations accelerated with OpenMP (static, ordered, no dead ends, partial error).
-        auto a2 = pagerankMonolithicBarrierfreeOmp<true, false, false>(y, yt, initStatic, {repeat, false, damping, Li, tolerance}, &C);
-        auto e2 = l1Norm(a2.ranks, a1.ranks);
-        printf("[%zu order; %zu size; %09.3f ms; %03d iters.] [%.4e err.] pagerankBarrierfreePartStatic\n", y.order(), y.size(), a2.time, a2.iterations, e2);
-      } while (0);
-      do {
-        // Find pagerank with barrier-free iterations accelerated with OpenMP (static, ordered, no dead ends, partial error, monolithic).
-        auto a2 = pagerankMonolithicBarrierfreeOmp<true, false, false>(y, yt, initStatic, {repeat, true, damping, Li, tolerance}, &C);
-        auto e2 = l1Norm(a2.ranks, a1.ranks);
-        printf("[%zu order; %zu size; %09.3f ms; %03d iters.] [%.4e err.] pagerankBarrierfreePartMonolithicStatic\n", y.order(), y.size(), a2.time, a2.iterations, e2);
-      } while (0);
-      do {
-        // Find pagerank with barrier-free iterations accelerated with OpenMP (static, ordered, no dead ends, partial error, levelwise).
-        auto a2 = pagerankLevelwiseBarrierfreeOmp<true, false, false>(y, yt, initStatic, {repeat, true, damping, Li, tolerance}, &C);
-        auto e2 = l1Norm(a2.ranks, a1.ranks);
-        printf("[%zu order; %zu size; %09.3f ms; %03d iters.] [%.4e err.] pagerankBarrierfreePartLevelwiseStatic\n", y.order(), y.size(), a2.time, a2.iterations, e2);
-      } while (0);
-    } while (0);
+    vector<K> lv;
+    phase(y, "levels", [&]() { lv = S.levels(); });
+    K nl = lv.empty()? 0 : *max_element(lv.begin(), lv.end()) + 1;
+    w.log("- components: %zu\n", S.size());
+    w.log("- blockgraph-levels: %d\n", nl);
+    PagerankData<G> C {S.components(), S.blockgraph(), S.blockgraphTranspose(), move(lv), &R, &kc, S.componentIds(), &ksOld, &dsOld};
+    PagerankOptions<T> o {repeat, false, damping, Li, tolerance};
+    size_t na = 0;
+    phase(y, "mark-affected", [&]() { na = pagerankDynamicVertices(x, xt, y, yt, o, &C).second; });
+    w.log("- affected-vertices: %zu\n", na);
+    vector<T> r1;
+    phase(y, "reference", [&]() { r1 = referenceRanks(y, yt, damping); });
 
     // Adjust ranks for dynamic Pagerank.
-    ranksAdj.resize(y.span());
-    adjustRanks(ranksAdj, ranksOld, ksOld, ks, 0.0f, float(ksOld.size())/ks.size(), 1.0f/ks.size());
-
-    do {
-      do {
-        // Find pagerank accelerated with OpenMP (naive dynamic, unordered, no dead ends).
-        auto a2 = pagerankMonolithicOmp<false, false>(y, yt, initDynamic, {repeat, false, damping, Li, tolerance}, &C);
-        auto e2 = l1Norm(a2.ranks, a1.ranks);
-        printf("[%zu order; %zu size; %09.3f ms; %03d iters.] [%.4e err.] pagerankOmpUnorderedNaiveDynamic\n", y.order(), y.size(), a2.time, a2.iterations, e2);
-      } while (0);
-      do {
-        // Find pagerank accelerated with OpenMP (naive dynamic, unordered, no dead ends, monolithic).
-        auto a2 = pagerankMonolithicOmp<false, false>(y, yt, initDynamic, {repeat, true, damping, Li, tolerance}, &C);
-        auto e2 = l1Norm(a2.ranks, a1.ranks);
-        printf("[%zu order; %zu size; %09.3f ms; %03d iters.] [%.4e err.] pagerankOmpUnorderedMonolithicNaiveDynamic\n", y.order(), y.size(), a2.time, a2.iterations, e2);
-      } while (0);
-      do {
-        // Find pagerank accelerated with OpenMP (naive dynamic, unordered, no dead ends, levelwise).
-        auto a2 = pagerankLevelwiseOmp<false, false>(y, yt, initDynamic, {repeat, true, damping, Li, tolerance}, &C);
-        auto e2 = l1Norm(a2.ranks, a1.ranks);
-        printf("[%zu order; %zu size; %09.3f ms; %03d iters.] [%.4e err.] pagerankOmpUnorderedLevelwiseNaiveDynamic\n", y.order(), y.size(), a2.time, a2.iterations, e2);
-      } while (0);
-      do {
-        // Find pagerank accelerated with OpenMP (naive dynamic, ordered, no dead ends).
-        auto a2 = pagerankMonolithicOmp<true, false>(y, yt, initDynamic, {repeat, false, damping, Li, tolerance}, &C);
-        auto e2 = l1Norm(a2.ranks, a1.ranks);
-        printf("[%zu order; %zu size; %09.3f ms; %03d iters.] [%.4e err.] pagerankOmpOrderedNaiveDynamic\n", y.order(), y.size(), a2.time, a2.iterations, e2);
-      } while (0);
-      do {
-        // Find pagerank accelerated with OpenMP (naive dynamic, ordered, no dead ends, monolithic).
-        auto a2 = pagerankMonolithicOmp<true, false>(y, yt, initDynamic, {repeat, true, damping, Li, tolerance}, &C);
-        auto e2 = l1Norm(a2.ranks, a1.ranks);
-        printf("[%zu order; %zu size; %09.3f ms; %03d iters.] [%.4e err.] pagerankOmpOrderedMonolithicNaiveDynamic\n", y.order(), y.size(), a2.time, a2.iterations, e2);
-      } while (0);
-      do {
-        // Find pagerank accelerated with OpenMP (naive dynamic, ordered, no dead ends, levelwise).
-        auto a2 = pagerankLevelwiseOmp<true, false>(y, yt, initDynamic, {repeat, true, damping, Li, tolerance}, &C);
-        auto e2 = l1Norm(a2.ranks, a1.ranks);
-        printf("[%zu order; %zu size; %09.3f ms; %03d iters.] [%.4e err.] pagerankOmpOrderedLevelwiseNaiveDynamic\n", y.order(), y.size(), a2.time, a2.iterations, e2);
-      } while (0);
-      do {
-        // Find pagerank with barrier-free iterations accelerated with OpenMP (naive dynamic, ordered, no dead ends, full error).
-        auto a2 = pagerankMonolithicBarrierfreeOmp<true, false, true>(y, yt, initDynamic, {repeat, false, damping, Li, tolerance}, &C);
-        auto e2 = l1Norm(a2.ranks, a1.ranks);
-        printf("[%zu order; %zu size; %09.3f ms; %03d iters.] [%.4e err.] pagerankBarrierfreeFullNaiveDynamic\n", y.order(), y.size(), a2.time, a2.iterations, e2);
-      } while (0);
-      do {
-        // Find pagerank with barrier-free iterations accelerated with OpenMP (naive dynamic, ordered, no dead ends, full error, monolithic).
-        auto a2 = pagerankMonolithicBarrierfreeOmp<true, false, true>(y, yt, initDynamic, {repeat, true, damping, Li, tolerance}, &C);
-        auto e2 = l1Norm(a2.ranks, a1.ranks);
-        printf("[%zu order; %zu size; %09.3f ms; %03d iters.] [%.4e err.] pagerankBarrierfreeFullMonolithicNaiveDynamic\n", y.order(), y.size(), a2.time, a2.iterations, e2);
-      } while (0);
-      do {
-        // Find pagerank with barrier-free iterations accelerated with OpenMP (naive dynamic, ordered, no dead ends, full error, levelwise).
-        auto a2 = pagerankLevelwiseBarrierfreeOmp<true, false, true>(y, yt, initDynamic, {repeat, true, damping, Li, tolerance}, &C);
-        auto e2 = l1Norm(a2.ranks, a1.ranks);
-        printf("[%zu order; %zu size; %09.3f ms; %03d iters.] [%.4e err.] pagerankBarrierfreeFullLevelwiseNaiveDynamic\n", y.order(), y.size(), a2.time, a2.iterations, e2);
-      } while (0);
-      do {
-        // Find pagerank with barrier-free iterations accelerated with OpenMP (naive dynamic, ordered, no dead ends, partial error).
-        auto a2 = pagerankMonolithicBarrierfreeOmp<true, false, false>(y, yt, initDynamic, {repeat, false, damping, Li, tolerance}, &C);
-        auto e2 = l1Norm(a2.ranks, a1.ranks);
-        printf("[%zu order; %zu size; %09.3f ms; %03d iters.] [%.4e err.] pagerankBarrierfreePartNaiveDynamic\n", y.order(), y.size(), a2.time, a2.iterations, e2);
-      } while (0);
-      do {
-        // Find pagerank with barrier-free iterations accelerated with OpenMP (naive dynamic, ordered, no dead ends, partial error, monolithic).
-        auto a2 = pagerankMonolithicBarrierfreeOmp<true, false, false>(y, yt, initDynamic, {repeat, true, damping, Li, tolerance}, &C);
-        auto e2 = l1Norm(a2.ranks, a1.ranks);
-        printf("[%zu order; %zu size; %09.3f ms; %03d iters.] [%.4e err.] pagerankBarrierfreePartMonolithicNaiveDynamic\n", y.order(), y.size(), a2.time, a2.iterations, e2);
-      } while (0);
-      do {
-        // Find pagerank with barrier-free iterations accelerated with OpenMP (naive dynamic, ordered, no dead ends, partial error, levelwise).
-        auto a2 = pagerankLevelwiseBarrierfreeOmp<true, false, false>(y, yt, initDynamic, {repeat, true, damping, Li, tolerance}, &C);
-        auto e2 = l1Norm(a2.ranks, a1.ranks);
-        printf("[%zu order; %zu size; %09.3f ms; %03d iters.] [%.4e err.] pagerankBarrierfreePartLevelwiseNaiveDynamic\n", y.order(), y.size(), a2.time, a2.iterations, e2);
-      } while (0);
-    } while (0);
-
-    do {
-      do {
-        // Find pagerank accelerated with OpenMP (dynamic, unordered, no dead ends).
-        auto a2 = pagerankMonolithicOmpDynamic<false, false>(x, xt, y, yt, initDynamic, {repeat, false, damping, Li, tolerance}, &C);
-        auto e2 = l1Norm(a2.ranks, a1.ranks);
-        printf("[%zu order; %zu size; %09.3f ms; %03d iters.] [%.4e err.] pagerankOmpUnorderedDynamic\n", y.order(), y.size(), a2.time, a2.iterations, e2);
-      } while (0);
-      do {
-        // Find pagerank accelerated with OpenMP (dynamic, unordered, no dead ends, monolithic).
-        auto a2 = pagerankMonolithicOmpDynamic<false, false>(x, xt, y, yt, initDynamic, {repeat, true, damping, Li, tolerance}, &C);
-        auto e2 = l1Norm(a2.ranks, a1.ranks);
-        printf("[%zu order; %zu size; %09.3f ms; %03d iters.] [%.4e err.] pagerankOmpUnorderedMonolithicDynamic\n", y.order(), y.size(), a2.time, a2.iterations, e2);
-      } while (0);
-      do {
-        // Find pagerank accelerated with OpenMP (dynamic, unordered, no dead ends, levelwise).
-        auto a2 = pagerankLevelwiseOmpDynamic<false, false>(x, xt, y, yt, initDynamic, {repeat, true, damping, Li, tolerance}, &C);
-        auto e2 = l1Norm(a2.ranks, a1.ranks);
-        printf("[%zu order; %zu size; %09.3f ms; %03d iters.] [%.4e err.] pagerankOmpUnorderedLevelwiseDynamic\n", y.order(), y.size(), a2.time, a2.iterations, e2);
-      } while (0);
-      do {
-        // Find pagerank accelerated with OpenMP (dynamic, ordered, no dead ends).
-        auto a2 = pagerankMonolithicOmpDynamic<true, false>(x, xt, y, yt, initDynamic, {repeat, false, damping, Li, tolerance}, &C);
-        auto e2 = l1Norm(a2.ranks, a1.ranks);
-        printf("[%zu order; %zu size; %09.3f ms; %03d iters.] [%.4e err.] pagerankOmpOrderedDynamic\n", y.order(), y.size(), a2.time, a2.iterations, e2);
-      } while (0);
-      do {
-        // Find pagerank accelerated with OpenMP (dynamic, ordered, no dead ends, monolithic).
-        auto a2 = pagerankMonolithicOmpDynamic<true, false>(x, xt, y, yt, initDynamic, {repeat, true, damping, Li, tolerance}, &C);
-        auto e2 = l1Norm(a2.ranks, a1.ranks);
-        printf("[%zu order; %zu size; %09.3f ms; %03d iters.] [%.4e err.] pagerankOmpOrderedMonolithicDynamic\n", y.order(), y.size(), a2.time, a2.iterations, e2);
-      } while (0);
-      do {
-        // Find pagerank accelerated with OpenMP (dynamic, ordered, no dead ends, levelwise).
-        auto a2 = pagerankLevelwiseOmpDynamic<true, false>(x, xt, y, yt, initDynamic, {repeat, true, damping, Li, tolerance}, &C);
-        auto e2 = l1Norm(a2.ranks, a1.ranks);
-        printf("[%zu order; %zu size; %09.3f ms; %03d iters.] [%.4e err.] pagerankOmpOrderedLevelwiseDynamic\n", y.order(), y.size(), a2.time, a2.iterations, e2);
-      } while (0);
-      do {
-        // Find pagerank with barrier-free iterations accelerated with OpenMP (dynamic, ordered, no dead ends, full error).
-        auto a2 = pagerankMonolithicBarrierfreeOmpDynamic<true, false, true>(x, xt, y, yt, initDynamic, {repeat, false, damping, Li, tolerance}, &C);
-        auto e2 = l1Norm(a2.ranks, a1.ranks);
-        printf("[%zu order; %zu size; %09.3f ms; %03d iters.] [%.4e err.] pagerankBarrierfreeFullDynamic\n", y.order(), y.size(), a2.time, a2.iterations, e2);
-      } while (0);
-      do {
-        // Find pagerank with barrier-free iterations accelerated with OpenMP (dynamic, ordered, no dead ends, full error, monolithic).
-        auto a2 = pagerankMonolithicBarrierfreeOmpDynamic<true, false, true>(x, xt, y, yt, initDynamic, {repeat, true, damping, Li, tolerance}, &C);
-        auto e2 = l1Norm(a2.ranks, a1.ranks);
-        printf("[%zu order; %zu size; %09.3f ms; %03d iters.] [%.4e err.] pagerankBarrierfreeFullMonolithicDynamic\n", y.order(), y.size(), a2.time, a2.iterations, e2);
-      } while (0);
-      do {
-        // Find pagerank with barrier-free iterations accelerated with OpenMP (dynamic, ordered, no dead ends, full error, levelwise).
-        auto a2 = pagerankLevelwiseBarrierfreeOmpDynamic<true, false, true>(x, xt, y, yt, initDynamic, {repeat, true, damping, Li, tolerance}, &C);
-        auto e2 = l1Norm(a2.ranks, a1.ranks);
-        printf("[%zu order; %zu size; %09.3f ms; %03d iters.] [%.4e err.] pagerankBarrierfreeFullLevelwiseDynamic\n", y.order(), y.size(), a2.time, a2.iterations, e2);
-      } while (0);
-      do {
-        // Find pagerank with barrier-free iterations accelerated with OpenMP (dynamic, ordered, no dead ends, partial error).
-        auto a2 = pagerankMonolithicBarrierfreeOmpDynamic<true, false, false>(x, xt, y, yt, initDynamic, {repeat, false, damping, Li, tolerance}, &C);
-        auto e2 = l1Norm(a2.ranks, a1.ranks);
-        printf("[%zu order; %zu size; %09.3f ms; %03d iters.] [%.4e err.] pagerankBarrierfreePartDynamic\n", y.order(), y.size(), a2.time, a2.iterations, e2);
-      } while (0);
-      do {
-        // Find pagerank with barrier-free iterations accelerated with OpenMP (dynamic, ordered, no dead ends, partial error, monolithic).
-        auto a2 = pagerankMonolithicBarrierfreeOmpDynamic<true, false, false>(x, xt, y, yt, initDynamic, {repeat, true, damping, Li, tolerance}, &C);
-        auto e2 = l1Norm(a2.ranks, a1.ranks);
-        printf("[%zu order; %zu size; %09.3f ms; %03d iters.] [%.4e err.] pagerankBarrierfreePartMonolithicDynamic\n", y.order(), y.size(), a2.time, a2.iterations, e2);
-      } while (0);
-      do {
-        // Find pagerank with barrier-free iterations accelerated with OpenMP (dynamic, ordered, no dead ends, partial error, levelwise).
-        auto a2 = pagerankMonolithicBarrierfreeOmpDynamic<true, false, false>(x, xt, y, yt, initDynamic, {repeat, true, damping, Li, tolerance}, &C);
-        auto e2 = l1Norm(a2.ranks, a1.ranks);
-        printf("[%zu order; %zu size; %09.3f ms; %03d iters.] [%.4e err.] pagerankBarrierfreePartLevelwiseDynamic\n", y.order(), y.size(), a2.time, a2.iterations, e2);
-      } while (0);
-    } while (0);
+    phase(y, "adjust-ranks", [&]() {
+      ranksAdj.resize(y.span());
+      adjustRanks(ranksAdj, ranksOld, ksOld, ks, 0.0f, float(ksOld.size())/ks.size(), 1.0f/ks.size());
+    });
+
+    // Run selected algorithms.
+    BatchContext bc {x, xt, y, yt, initStatic, initDynamic, &C, o};
+    for (const auto& g : pagerankAlgorithms()) {
+      if (!hasAlgorithm(opt, g.name)) continue;
+      PagerankResult<T> a2({});
+      if (pc.isOpen()) pc.start();
+      float t = measureDuration([&]() { a2 = g.run(bc); });
+      BenchmarkRecord r = r0;
+      r.batch = b; r.order = y.order(); r.size = y.size();
+      r.kind  = g.kind; r.name = g.name;
+      r.time  = a2.time;
+      r.setup = max(t - a2.time*repeat, 0.0f) / repeat;
+      r.iterations = a2.iterations;
+      r.error  = l1Norm(a2.ranks, r1);
+      if (tolerance < g.minTolerance) r.note = "error bounded by 16-bit storage, not tolerance";
+      r.work   = move(a2.threads);
+      r.counts = pc.stop();
+      w.write(r);
+    }
 
     // Now time to move on to next batch.
-    xo = move(yo);
+    ++b;
+  }
+}
+
+
+void runPagerank(BenchmarkWriter& w, PerfCounters& pc, const Options& o, const string& graph, const SnapTemporalEdges<>& data) {
+  size_t M = data.size(), steps = o.steps;
+  w.log("Temporal edges: %zu\n\n", M);
+  for (size_t batch : o.batches) {
+    size_t skip = max(int64_t(M/steps) - int64_t(batch), int64_t(0));
+    w.log("# Batch size %.0e\n", double(batch));
+    runPagerankBatch(w, pc, o, graph, data, batch, skip);
+    w.log("\n");
   }
 }
 
 
-void runPagerank(const string& data, int repeat) {
-  size_t M = countLines(data), steps = 10;
-  printf("Temporal edges: %zu\n\n", M);
-  for (size_t batch=100; batch<=1000000; batch*=10) {
-    size_t skip = max(int64_t(M/steps) - int64_t(batch), 0L);
-    printf("# Batch size %.0e\n", double(batch));
-    runPagerankBatch(data, batch, skip, repeat);
+// Load temporal edges from text, or binary snapshot (if present).
+bool readTemporalEdges(SnapTemporalEdges<>& a, const char *file) {
+  MappedFile f(file);
+  if (!f.data()) return false;
+  SnapTemporalBinary<> b;
+  if (readSnapTemporalBinaryW(b, f.data(), f.size())) snapTemporalEdgesOmpW(a, b);
+  else readSnapTemporalOmpW(a, f.data(), f.size());
+  return true;
+}
+
+
+
+
+// CHECK
+// -----
+// Self-checks upon the whole graph, with known outcomes. Returns the number
+// of checks failed.
+
+int runPagerankCheck(const Options& o, const SnapTemporalEdges<>& data) {
+  using K = Key;
+  using T = Rank;
+  enum NormFunction { L0=0, L1=1, L2=2, Li=3 };
+  OutGraph x;
+  auto xt = transposeWithDegree(x);
+  vector<pair<K, K>> del, ins;
+  for (size_t i=0; i<data.size(); ++i)
+    ins.push_back({K(data.sources[i]), K(data.targets[i])});
+  applyBatchU(x, xt, del, ins);
+  PagerankOptions<T> o0 {1, false, 0.85f, Li, 1e-8f};
+  PagerankOptions<T> o1 {1, true,  0.85f, Li, 1e-8f};
+  auto r0 = referenceRanks(x, xt, 0.85);
+  auto q  = &r0;
+  int  nf = 0;
+  auto check = [&](const char *name, bool ok, const char *fmt, auto... args) {
+    printf("%s %s: ", ok? "[ok]    " : "[FAILED]", name);
+    printf(fmt, args...);
     printf("\n");
+    if (!ok) ++nf;
+  };
+  printf("Checking graph %s (%zu order; %zu size) with %d threads ...\n", o.file.c_str(), size_t(x.order()), size_t(x.size()), omp_get_max_threads());
+  // Seeded with converged ranks, levelwise engines must stay converged. This
+  // fails without the teleport pre-scaling only when the graph has dead ends.
+  {
+    auto fe = [&](const auto& a) { return double(l1Norm(a.ranks, r0)); };
+    auto e0 = fe(pagerankMonolithicOmp<true, true>(x, xt, q, o0));
+    auto E  = max(2 * e0, 1e-6);
+    vector<pair<const char*, PagerankResult<T>>> as;
+    as.push_back({"pagerankOmpUnorderedLevelwise",    pagerankLevelwiseOmp<false, true>(x, xt, q, o1)});
+    as.push_back({"pagerankOmpOrderedLevelwise",      pagerankLevelwiseOmp<true, true>(x, xt, q, o1)});
+    as.push_back({"pagerankSeqOrderedLevelwise",      pagerankLevelwiseSeq<true, true>(x, xt, q, o1)});
+    as.push_back({"pagerankBarrierfreeFullLevelwise", pagerankLevelwiseBarrierfreeOmp<true, true, true>(x, xt, q, o1)});
+    as.push_back({"pagerankBarrierfreePartLevelwise", pagerankLevelwiseBarrierfreeOmp<true, true, false>(x, xt, q, o1)});
+    for (const auto& [name, a] : as)
+      check(name, fe(a) <= E && a.iterations <= 2, "seeded with converged ranks, %.4e err. (<= %.4e), %d iters.", fe(a), E, a.iterations);
   }
+  // Stealing engine must not take many more passes than the ordered one (in
+  // any of a few runs, as passes depend upon thread timing).
+  {
+    auto a0 = pagerankMonolithicOmp<true, true>(x, xt, (const vector<T>*) nullptr, o0);
+    auto e0 = double(l1Norm(a0.ranks, r0));
+    int  L  = 2 * a0.iterations + 5, l1 = 0;
+    double e1 = 0;
+    for (int i=0; i<10; ++i) {
+      auto a1 = pagerankMonolithicStealingOmp<true>(x, xt, (const vector<T>*) nullptr, o0);
+      l1 = max(l1, a1.iterations);
+      e1 = max(e1, double(l1Norm(a1.ranks, r0)));
+    }
+    check("pagerankStealingStatic", l1 <= L && e1 <= max(2 * e0, 1e-6), "%d iters. (<= %d), %.4e err. (ordered %.4e)", l1, L, e1, e0);
+  }
+  printf("%d checks failed.\n", nf);
+  return nf;
 }
 
 
+
+
+// SERVE
+// -----
+// Streaming service, from an optional base graph. Metrics of each batch are
+// written to stderr (or output), as replies to queries use stdout.
+
+int runPagerankService(const Options& o) {
+  using K = Key;
+  using T = Rank;
+  enum NormFunction { L0=0, L1=1, L2=2, Li=3 };
+  OutGraph x;
+  auto xt = transposeWithDegree(x);
+  if (!o.file.empty()) {
+    SnapTemporalEdges<> data;
+    if (!readTemporalEdges(data, o.file.c_str())) { fprintf(stderr, "Cannot read graph %s\n", o.file.c_str()); return 1; }
+    vector<pair<K, K>> del, ins;
+    for (size_t i=0; i<data.size(); ++i)
+      ins.push_back({K(data.sources[i]), K(data.targets[i])});
+    applyBatchU(x, xt, del, ins);
+  }
+  FILE *out = o.output.empty()? stderr : fopen(o.output.c_str(), "w");
+  if (!out) { fprintf(stderr, "Cannot write to %s\n", o.output.c_str()); return 1; }
+  omp_set_num_threads(o.threads[0]);
+  fprintf(out, "Serving graph %s (%zu order; %zu size) ...\n", o.file.empty()? "(empty)" : o.file.c_str(), size_t(x.order()), size_t(x.size()));
+  fflush(out);
+  EdgeBatchQueue<K> q(o.batchSize, o.batchDelay);
+  RankSnapshots<T>  s;
+  PagerankOptions<T> po {1, false, 0.85f, Li, 1e-8f};
+  bool ok = true;
+  pagerankStreamInitialOmp(x, xt, s, po);
+  thread ti([&]() {
+#ifdef __linux__
+    if (!o.socket.empty()) { ok = pagerankStreamSocket(o.socket.c_str(), q, s); return; }
+#endif
+    pagerankStreamStdin(q, s);
+  });
+  pagerankStreamOmp(x, xt, q, s, po, o.prepareThreads, [&](const auto& m) {
+    fprintf(out, "%s\n", pagerankStreamMetricsString(m).c_str());
+    fflush(out);
+  });
+  ti.join();
+  if (!ok) fprintf(stderr, "Cannot serve on socket %s\n", o.socket.c_str());
+  if (out!=stderr) fclose(out);
+  return ok? 0 : 1;
+}
+
+
+
+
+// MAIN
+// ----
+
 int main(int argc, char **argv) {
-  char *file = argv[1];
-  int repeat = argc>2? stoi(argv[2]) : 5;
-  printf("Using graph %s ...\n", file);
-  string data = readFile(file);
-  omp_set_num_threads(MAX_THREADS);
-  printf("OMP_NUM_THREADS=%d\n", MAX_THREADS);
-  runPagerank(data, repeat);
-  printf("\n");
+  Options o;
+  if (!parseOptions(o, argc, argv)) { printUsage(argv[0]); return 1; }
+  if (o.help) { printUsage(argv[0]); return 0; }
+  if (o.serve) return runPagerankService(o);
+  if (o.list) {
+    for (const auto& g : pagerankAlgorithms())
+      printf("%s (%s)\n", g.name, g.kind);
+    return 0;
+  }
+  FILE *out = o.output.empty()? stdout : fopen(o.output.c_str(), "w");
+  if (!out) { fprintf(stderr, "Cannot write to %s\n", o.output.c_str()); return 1; }
+  BenchmarkWriter w(out, o.format);
+  string graph = o.file.substr(o.file.find_last_of('/')+1);
+  graph = graph.substr(0, graph.find_last_of('.'));
+  w.log("Using graph %s ...\n", o.file.c_str());
+  SnapTemporalEdges<> data;
+  bool ok = false;
+  float t = measureDuration([&]() { ok = readTemporalEdges(data, o.file.c_str()); });
+  if (!ok) { fprintf(stderr, "Cannot read graph %s\n", o.file.c_str()); return 1; }
+  w.log("Loading graph took %.3f ms\n", t);
+  if (o.check) {
+    int nf = 0;
+    for (int T : o.threads) {
+      omp_set_num_threads(T);
+      nf += runPagerankCheck(o, data);
+    }
+    return nf>0? 1 : 0;
+  }
+  if (!o.snapshot.empty()) {
+    ofstream f(o.snapshot, ios::binary);
+    if (!f || !writeSnapTemporalBinary(f, data)) { fprintf(stderr, "Cannot write snapshot %s\n", o.snapshot.c_str()); return 1; }
+  }
+  PerfCounters pc;
+  for (int T : o.threads) {
+    omp_set_num_threads(T);
+    w.log("OMP_NUM_THREADS=%d\n", T);
+    if (o.perf && !pc.open()) fprintf(stderr, "Cannot open hardware counters (perf_event_open)\n");
+    runPagerank(w, pc, o, graph, data);
+    w.log("\n");
+  }
+  if (out!=stdout) fclose(out);
   return 0;
 }
@@ -503,6 +503,44 @@ using std::cout;
 #endif
 
 
+#ifndef GRAPH_UPDATE_EDGES_SEARCH
+// Remove, then add edges (sorted by source) to the bitset of each source.
+// Each source is handled by a separate thread; returns change in size.
+template <class B, class K>
+ptrdiff_t updateBitsetsOmpU(vector<B>& eto, const vector<pair<K, K>>& del, const vector<pair<K, K>>& ins) {
+  vector<K> us; ptrdiff_t dM = 0;
+  for (const auto& [u, v] : del)
+    if (us.empty() || us.back()!=u) us.push_back(u);
+  for (const auto& [u, v] : ins)
+    if (us.empty() || us.back()!=u) us.push_back(u);
+  sortValues(us); us.resize(uniqueValues(us));
+  auto fl = [](const auto& e, K u) { return e.first < u; };
+  #pragma omp parallel for schedule(dynamic, 64) reduction(+:dM)
+  for (size_t i=0; i<us.size(); ++i) {
+    K  u  = us[i];
+    auto& e  = eto[u];
+    size_t n = e.size();
+    auto db = lower_bound(del.begin(), del.end(), u, fl);
+    auto ib = lower_bound(ins.begin(), ins.end(), u, fl);
+    for (; db!=del.end() && db->first==u; ++db)
+      e.remove(db->second);
+    for (; ib!=ins.end() && ib->first==u; ++ib)
+      e.add(ib->second);
+    e.correct();
+    dM += ptrdiff_t(e.size()) - ptrdiff_t(n);
+  }
+  return dM;
+}
+
+// Vertices of added edges must already exist.
+#define GRAPH_UPDATE_EDGES_SEARCH(K, V, E, M, eto) \
+  inline bool updateEdges(const vector<pair<K, K>>& del, const vector<pair<K, K>>& ins) { \
+    M += updateBitsetsOmpU(eto, del, ins); \
+    return true; \
+  }
+#endif
+
+
 #ifndef GRAPH_CORRECT_FROM
 #define GRAPH_CORRECT_FROM(K, V, E, x) \
   inline bool correct(bool unq=false) noexcept { return x.correct(unq); }
@@ -679,6 +717,7 @@ class OutDiGraph {
   GRAPH_REMOVE_EDGES_SEARCH(K, V, E, M, eto)
   GRAPH_REMOVE_INEDGES_SEARCH(K, V, E, M, eto)
   GRAPH_REMOVE_VERTEX(K, V, E, N, vexists, vvalues)
+  GRAPH_UPDATE_EDGES_SEARCH(K, V, E, M, eto)
 };
 
 template <class K=int, class V=NONE, class E=NONE>
@@ -2,6 +2,11 @@
 #include <istream>
 #include <ostream>
 #include <utility>
+#include <cstdint>
+#include <cstring>
+#ifdef __F16C__
+#include <immintrin.h>
+#endif
 
 using std::pair;
 using std::istream;
@@ -52,3 +57,98 @@ struct None {
 #define tclass2s template <class, class, class...> class
 #define tclass3s template <class, class, class, class...> class
 #endif
+
+
+
+
+// BFLOAT16
+// --------
+// Storage-only 16-bit float (upper half of float), arithmetic is in float.
+
+#ifndef BFLOAT16
+struct Bfloat16 {
+  uint16_t bits;
+
+  // Conversion operators (round to nearest even).
+  operator float() const noexcept {
+    uint32_t u = uint32_t(bits) << 16; float a;
+    memcpy(&a, &u, sizeof(a));
+    return a;
+  }
+
+  // Stream operators.
+  friend istream& operator>>(istream& a, Bfloat16& x) { float v; a >> v; x = v; return a; }
+  friend ostream& operator<<(ostream& a, Bfloat16 x)  { return a << float(x); }
+
+  // Lifetime operators.
+  Bfloat16() noexcept : bits(0) {}
+  Bfloat16(float v) noexcept {
+    uint32_t u; memcpy(&u, &v, sizeof(u));
+    if ((u & 0x7F800000u)==0x7F800000u && (u & 0x007FFFFFu)) { bits = uint16_t((u >> 16) | 0x40); return; }  // keep NaN
+    u += 0x7FFFu + ((u >> 16) & 1);
+    bits = uint16_t(u >> 16);
+  }
+};
+#define BFLOAT16 Bfloat16
+#endif
+
+
+
+
+// FLOAT16
+// -------
+// Storage-only IEEE half float, arithmetic is in float.
+
+#ifndef FLOAT16
+struct Float16 {
+  uint16_t bits;
+
+  // Conversion operators (round to nearest even).
+  operator float() const noexcept {
+#ifdef __F16C__
+    return _cvtsh_ss(bits);
+#else
+    uint32_t s = uint32_t(bits & 0x8000) << 16;
+    uint32_t e = (bits >> 10) & 0x1F, m = bits & 0x3FF, u;
+    if (e==0x1F) u = s | 0x7F800000u | (m << 13);        // inf, nan
+    else if (e)  u = s | ((e + 112) << 23) | (m << 13);  // normal
+    else if (m) {                                        // subnormal
+      e = 113;
+      while (!(m & 0x400)) { m <<= 1; --e; }
+      u = s | (e << 23) | ((m & 0x3FF) << 13);
+    }
+    else u = s;
+    float a; memcpy(&a, &u, sizeof(a));
+    return a;
+#endif
+  }
+
+  // Stream operators.
+  friend istream& operator>>(istream& a, Float16& x) { float v; a >> v; x = v; return a; }
+  friend ostream& operator<<(ostream& a, Float16 x)  { return a << float(x); }
+
+  // Lifetime operators.
+  Float16() noexcept : bits(0) {}
+  Float16(float v) noexcept {
+#ifdef __F16C__
+    bits = _cvtss_sh(v, 0);
+#else
+    uint32_t u; memcpy(&u, &v, sizeof(u));
+    uint32_t s = (u >> 16) & 0x8000, x = u & 0x7FFFFFFFu;
+    if (x >= 0x7F800000u) { bits = uint16_t(s | 0x7C00 | (x > 0x7F800000u? 0x200 : 0)); return; }  // inf, nan
+    if (x >= 0x477FF000u) { bits = uint16_t(s | 0x7C00); return; }  // overflow
+    if (x <  0x38800000u) {                                          // subnormal, or zero
+      if (x < 0x33000000u) { bits = uint16_t(s); return; }
+      uint32_t e = x >> 23, m = (x & 0x7FFFFF) | 0x800000, sh = 126 - e;
+      uint32_t h = m >> sh, rb = m & ((1u << sh) - 1), hf = 1u << (sh-1);
+      if (rb > hf || (rb==hf && (h & 1))) ++h;
+      bits = uint16_t(s | h);
+      return;
+    }
+    x += 0xFFF + ((x >> 13) & 1);
+    bits = uint16_t(s | ((x - 0x38000000u) >> 13));
+#endif
+  }
+};
+#define FLOAT16 Float16
+#endif
@@ -8,6 +8,10 @@
 #include <iostream>
 #include <type_traits>
 #include <iterator>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 using std::pair;
 using std::array;
@@ -38,6 +42,49 @@ string readFile(const char *pth) {
 
 
 
+// MAP-FILE
+// --------
+// Read-only memory map of a file (unmapped on destruction).
+
+class MappedFile {
+  const char *ptr = nullptr;
+  size_t len = 0;
+
+  public:
+  inline const char* data() const noexcept { return ptr; }
+  inline size_t size()      const noexcept { return len; }
+
+  bool open(const char *pth) {
+    close();
+    int fd = ::open(pth, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) < 0) { ::close(fd); return false; }
+    len = st.st_size;
+    void *p = len>0? mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0) : nullptr;
+    ::close(fd);
+    if (p == MAP_FAILED) { len = 0; return false; }
+    if (p) madvise(p, len, MADV_WILLNEED);
+    ptr = (const char*) p;
+    return true;
+  }
+
+  void close() {
+    if (ptr) munmap((void*) ptr, len);
+    ptr = nullptr;
+    len = 0;
+  }
+
+  MappedFile() = default;
+  MappedFile(const char *pth) { open(pth); }
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  ~MappedFile() { close(); }
+};
+
+
+
+
 // WRITE
 // -----
 
@@ -10,3 +10,4 @@
 #include "_vector.hxx"
 #include "_queue.hxx"
 #include "_bitset.hxx"
+#include "_simd.hxx"
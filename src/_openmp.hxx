@@ -5,7 +5,13 @@
 #include <array>
 #include <vector>
 #include <map>
+#include <cstdint>
+#include <type_traits>
 #include <omp.h>
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
 #include "_vector.hxx"
 
 using std::array;
@@ -17,6 +23,8 @@ using std::move;
 using std::abs;
 using std::max;
 using std::sqrt;
+using std::min;
+using std::is_arithmetic;
 
 
 
@@ -89,6 +97,66 @@ inline void fillValueOmpU(vector<T>& a, size_t i, size_t N, const V& v) {
 
 
 
+// FOR-EACH-SLICE
+// --------------
+// Splits [0, N) into one contiguous slice per thread, with the same mapping
+// of slices to threads as barrier-free iterations (ceilDiv(N, threads) each).
+
+template <class F>
+void forEachSliceOmp(size_t N, F fn) {
+  if (N<SIZE_MIN_OMPM) { fn(size_t(0), N); return; }
+  int    TS = omp_get_max_threads();
+  size_t DN = (N + TS-1) / TS;
+  #pragma omp parallel for schedule(static, 1)
+  for (int t=0; t<TS; ++t) {
+    size_t i = min(t*DN, N), I = min(i+DN, N);
+    if (i<I) fn(i, I);
+  }
+}
+
+
+
+
+// FIRST-TOUCH
+// -----------
+// Pages of a new vector are zeroed (touched) by the thread creating it, which
+// places all of them on its NUMA node. Zeroed pages are dropped (they read
+// back as zero) and touched again by the thread owning each slice.
+
+template <class T>
+void dropZeroPagesU(vector<T>& a) {
+  static_assert(is_arithmetic<T>::value, "Only zeroed arithmetic values can be dropped!");
+#ifdef __linux__
+  uintptr_t P = uintptr_t(sysconf(_SC_PAGESIZE));
+  uintptr_t i = (uintptr_t(a.data()) + P-1) & ~(P-1);
+  uintptr_t I = uintptr_t(a.data() + a.size()) & ~(P-1);
+  if (I>i) madvise((void*) i, I-i, MADV_DONTNEED);
+#endif
+}
+
+
+// Vector must have only zero values.
+template <class T>
+void firstTouchOmpU(vector<T>& a) {
+  size_t N = a.size();
+  if (N<SIZE_MIN_OMPM) return;
+  dropZeroPagesU(a);
+  forEachSliceOmp(N, [&](size_t i, size_t I) {
+    for (size_t k=i; k<I; ++k)
+      a[k] = T();
+  });
+}
+
+template <class T>
+inline vector<T> createVectorOmp(size_t N) {
+  vector<T> a(N);
+  firstTouchOmpU(a);
+  return a;
+}
+
+
+
+
 // SUM-VALUES
 // ----------
 
@@ -479,7 +547,7 @@ inline void multiplyValuesOmpW(vector<TA>& a, const vector<TX>& x, const vector<
 // --------------
 
 template <class T, class TA, class V>
-void multiplyValueOmp(const T *x, const TA *a, size_t N, const V& v) {
+void multiplyValueOmp(const T *x, TA *a, size_t N, const V& v) {
   if (N<SIZE_MIN_OMPM) { multiplyValue(x, a, N, v); return; }
   #pragma omp parallel for schedule(auto)
   for (size_t i=0; i<N; i++)
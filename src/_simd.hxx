@@ -0,0 +1,208 @@
+#pragma once
+#include <cstdint>
+#include <type_traits>
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+#include "_ctypes.hxx"
+
+using std::is_same;
+using std::is_integral;
+
+
+
+
+// SIMD-LANES
+// ----------
+// Gather kernels are picked at compile time (-mavx2, -mavx512f, -march=native).
+// Without them, a portable scalar fallback is used.
+
+#ifndef SIMD_LANES
+#if defined(__AVX512F__)
+#define SIMD_LANES 16
+#elif defined(__AVX2__)
+#define SIMD_LANES 8
+#else
+#define SIMD_LANES 8
+#endif
+#endif
+
+#ifndef SIMD_F16C
+#ifdef __F16C__
+#define SIMD_F16C true
+#else
+#define SIMD_F16C false
+#endif
+#endif
+
+
+// Storage types supported by gather kernels (need 32-bit indices).
+// 16-bit types are gathered as 32-bit words, so storage must be padded by one.
+template <class T, class K>
+constexpr bool simdGatherable() {
+  bool tv = is_same<T, float>::value || is_same<T, Bfloat16>::value || (is_same<T, Float16>::value && SIMD_F16C);
+  return tv && is_integral<K>::value && sizeof(K)==4;
+}
+
+
+
+
+// GATHER-FLOAT (AVX2)
+// -------------------
+
+#if defined(__AVX2__) && !defined(__AVX512F__)
+template <class T>
+inline __m256 gatherFloat8(const T *x, __m256i is, __m256i m) {
+  if constexpr (is_same<T, float>::value) {
+    return _mm256_mask_i32gather_ps(_mm256_setzero_ps(), x, is, _mm256_castsi256_ps(m), 4);
+  }
+  else {
+    __m256i w = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), (const int*) x, is, m, 2);
+    if constexpr (is_same<T, Bfloat16>::value) return _mm256_castsi256_ps(_mm256_slli_epi32(w, 16));
+#ifdef __F16C__
+    w = _mm256_and_si256(w, _mm256_set1_epi32(0xFFFF));
+    w = _mm256_permute4x64_epi64(_mm256_packus_epi32(w, w), 0x08);
+    return _mm256_cvtph_ps(_mm256_castsi256_si128(w));
+#else
+    return _mm256_setzero_ps();
+#endif
+  }
+}
+
+template <class T>
+inline __m256 gatherFloat8(const T *x, __m256i is) {
+  return gatherFloat8(x, is, _mm256_set1_epi32(-1));
+}
+
+inline void addFloat8U(__m256d& a0, __m256d& a1, __m256 v) {
+  a0 = _mm256_add_pd(a0, _mm256_cvtps_pd(_mm256_castps256_ps128(v)));
+  a1 = _mm256_add_pd(a1, _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)));
+}
+
+inline double sumDouble4(__m256d a) {
+  __m128d b = _mm_add_pd(_mm256_castpd256_pd128(a), _mm256_extractf128_pd(a, 1));
+  return _mm_cvtsd_f64(_mm_add_sd(b, _mm_unpackhi_pd(b, b)));
+}
+#endif
+
+
+
+
+// GATHER-FLOAT (AVX-512)
+// ----------------------
+
+#if defined(__AVX512F__)
+template <class T>
+inline __m512 gatherFloat16(const T *x, __m512i is, __mmask16 m) {
+  if constexpr (is_same<T, float>::value) {
+    return _mm512_mask_i32gather_ps(_mm512_setzero_ps(), m, is, x, 4);
+  }
+  else {
+    __m512i w = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), m, is, (const int*) x, 2);
+    if constexpr (is_same<T, Bfloat16>::value) return _mm512_castsi512_ps(_mm512_slli_epi32(w, 16));
+    return _mm512_cvtph_ps(_mm512_cvtepi32_epi16(w));
+  }
+}
+
+inline void addFloat16U(__m512d& a0, __m512d& a1, __m512 v) {
+  a0 = _mm512_add_pd(a0, _mm512_cvtps_pd(_mm512_castps512_ps256(v)));
+  a1 = _mm512_add_pd(a1, _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(v), 1))));
+}
+#endif
+
+
+
+
+// SUM-VALUES-AT (SIMD)
+// --------------------
+// Sum of values at given indices, accumulated in double.
+
+template <class T, class K>
+double sumValuesAtSimd(const T *x, const K *is, size_t N) {
+  double a0 = 0, a1 = 0, a2 = 0, a3 = 0;
+  size_t i = 0;
+#if defined(__AVX512F__)
+  if constexpr (simdGatherable<T, K>()) {
+    __m512d b0 = _mm512_setzero_pd(), b1 = _mm512_setzero_pd();
+    for (; i+16<=N; i+=16) {
+      __m512i js = _mm512_loadu_si512((const void*) (is+i));
+      addFloat16U(b0, b1, gatherFloat16(x, js, __mmask16(0xFFFF)));
+    }
+    a0 = _mm512_reduce_add_pd(_mm512_add_pd(b0, b1));
+  }
+#elif defined(__AVX2__)
+  if constexpr (simdGatherable<T, K>()) {
+    __m256d b0 = _mm256_setzero_pd(), b1 = _mm256_setzero_pd();
+    for (; i+8<=N; i+=8) {
+      __m256i js = _mm256_loadu_si256((const __m256i*) (is+i));
+      addFloat8U(b0, b1, gatherFloat8(x, js));
+    }
+    a0 = sumDouble4(_mm256_add_pd(b0, b1));
+  }
+#endif
+  for (; i+4<=N; i+=4) {
+    a0 += double(x[is[i]]);   a1 += double(x[is[i+1]]);
+    a2 += double(x[is[i+2]]); a3 += double(x[is[i+3]]);
+  }
+  for (; i<N; ++i)
+    a0 += double(x[is[i]]);
+  return (a0 + a1) + (a2 + a3);
+}
+
+
+
+
+// SUM-VALUES-AT-LANES (SIMD)
+// --------------------------
+// Sums of values at in-edges of a group of vertices (one vertex per lane).
+// Meant for vertices with few in-edges, with group size up to SIMD_LANES.
+
+template <class T, class K>
+void sumValuesAtLanesW(double *a, const T *x, const K *vfrom, const K *efrom, const K *vs, size_t W) {
+#if defined(__AVX512F__)
+  if constexpr (simdGatherable<T, K>()) {
+    __mmask16 m = __mmask16((1u << W) - 1);
+    __m512i us = _mm512_maskz_loadu_epi32(m, (const void*) vs);
+    __m512i bs = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), m, us, (const int*) vfrom, 4);
+    __m512i es = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), m, _mm512_add_epi32(us, _mm512_set1_epi32(1)), (const int*) vfrom, 4);
+    __m512i ds = _mm512_sub_epi32(es, bs);
+    int     D  = _mm512_reduce_max_epi32(ds);
+    __m512d b0 = _mm512_setzero_pd(), b1 = _mm512_setzero_pd();
+    for (int j=0; j<D; ++j) {
+      __mmask16 mj = _mm512_cmpgt_epi32_mask(ds, _mm512_set1_epi32(j));
+      __m512i   js = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), mj, _mm512_add_epi32(bs, _mm512_set1_epi32(j)), (const int*) efrom, 4);
+      addFloat16U(b0, b1, gatherFloat16(x, js, mj));
+    }
+    double c[16];
+    _mm512_storeu_pd(c, b0); _mm512_storeu_pd(c+8, b1);
+    for (size_t l=0; l<W; ++l)
+      a[l] = c[l];
+    return;
+  }
+#elif defined(__AVX2__)
+  if constexpr (simdGatherable<T, K>()) {
+    if (W==8) {
+      __m256i us = _mm256_loadu_si256((const __m256i*) vs);
+      __m256i bs = _mm256_i32gather_epi32((const int*) vfrom, us, 4);
+      __m256i es = _mm256_i32gather_epi32((const int*) vfrom, _mm256_add_epi32(us, _mm256_set1_epi32(1)), 4);
+      __m256i ds = _mm256_sub_epi32(es, bs);
+      __m128i dm = _mm_max_epi32(_mm256_castsi256_si128(ds), _mm256_extracti128_si256(ds, 1));
+      dm = _mm_max_epi32(dm, _mm_shuffle_epi32(dm, 0x4E));
+      dm = _mm_max_epi32(dm, _mm_shuffle_epi32(dm, 0xB1));
+      int     D  = _mm_cvtsi128_si32(dm);
+      __m256d b0 = _mm256_setzero_pd(), b1 = _mm256_setzero_pd();
+      for (int j=0; j<D; ++j) {
+        __m256i mj = _mm256_cmpgt_epi32(ds, _mm256_set1_epi32(j));
+        __m256i js = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), (const int*) efrom, _mm256_add_epi32(bs, _mm256_set1_epi32(j)), mj, 4);
+        addFloat8U(b0, b1, gatherFloat8(x, js, mj));
+      }
+      _mm256_storeu_pd(a, b0); _mm256_storeu_pd(a+4, b1);
+      return;
+    }
+  }
+#endif
+  for (size_t l=0; l<W; ++l) {
+    K v = vs[l];
+    a[l] = sumValuesAtSimd(x, efrom+vfrom[v], size_t(vfrom[v+1] - vfrom[v]));
+  }
+}
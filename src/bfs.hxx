@@ -0,0 +1,59 @@
+#pragma once
+#include <utility>
+#include <vector>
+#include "_main.hxx"
+#include "vertices.hxx"
+
+using std::vector;
+using std::swap;
+
+
+
+
+// BFS-MARK (OMP)
+// --------------
+// Marks nodes reachable from given nodes, level by level.
+// Each level is expanded by multiple threads (marks are set atomically).
+// Optionally, only nodes within given depth are marked (D >= 0).
+
+template <class K>
+inline bool bfsMarkAtomicU(vector<char>& vis, K v) {
+  char old;
+  #pragma omp atomic read
+  old = vis[v];
+  if (old) return false;
+  #pragma omp atomic capture
+  { old = vis[v]; vis[v] = 1; }
+  return !old;
+}
+
+template <class G, class J>
+void bfsMarkOmpLoop(vector<char>& vis, const G& x, const J& us, int D=-1) {
+  using K = typename G::key_type;
+  vector<K> frnt, frnu;
+  for (auto u : us)
+    if (!vis[u]) { vis[u] = 1; frnt.push_back(u); }
+  for (int d=0; d!=D && !frnt.empty(); ++d) {
+    frnu.clear();
+    #pragma omp parallel
+    {
+      vector<K> a;
+      #pragma omp for schedule(dynamic, 64) nowait
+      for (size_t i=0; i<frnt.size(); ++i) {
+        x.forEachEdgeKey(frnt[i], [&](auto v) {
+          if (bfsMarkAtomicU(vis, v)) a.push_back(v);
+        });
+      }
+      #pragma omp critical
+      frnu.insert(frnu.end(), a.begin(), a.end());
+    }
+    swap(frnt, frnu);
+  }
+}
+
+template <class G, class J>
+inline auto bfsMarkOmp(const G& x, const J& us, int D=-1) {
+  auto vis = createContainer(x, char());
+  bfsMarkOmpLoop(vis, x, us, D);
+  return vis;
+}
@@ -50,6 +50,17 @@ auto componentIds(const G& x, const vector2d<K>& cs) {
   return a;
 }
 
+template <class G, class K>
+auto componentIdsOmp(const G& x, const vector2d<K>& cs) {
+  auto a = createContainer(x, K());
+  #pragma omp parallel for schedule(dynamic, 2048)
+  for (size_t i=0; i<cs.size(); ++i) {
+    for (K u : cs[i])
+      a[u] = K(i);
+  }
+  return a;
+}
+
 
 
 
@@ -5,6 +5,8 @@
 
 using std::vector;
 using std::transform;
+using std::max;
+using std::swap;
 
 
 
@@ -38,6 +40,21 @@ inline auto sourceOffsets(const G& x) {
 }
 
 
+// Pages of offsets are first touched by the thread that owns them.
+template <class G, class J, class T>
+auto sourceOffsetsAsOmp(const G& x, const J& ks, T _) {
+  size_t N = ks.size();
+  auto   a = createVectorOmp<T>(N+1);
+  forEachSliceOmp(N, [&](size_t i, size_t I) {
+    for (size_t j=i; j<I; ++j)
+      a[j+1] = T(x.degree(ks[j]));
+  });
+  for (size_t j=0; j<N; ++j)
+    a[j+1] += a[j];
+  return a;
+}
+
+
 
 
 // DESTINATION-INDICES
@@ -45,9 +62,12 @@ inline auto sourceOffsets(const G& x) {
 
 template <class G, class J, class T>
 auto destinationIndicesAs(const G& x, const J& ks, T _) {
-  auto ids = valueIndicesUnorderedMap(ks); vector<T> a;
+  vector<T> ids(x.span()), a; T i = 0;
+  a.reserve(x.size());
+  for (auto u : ks)
+    ids[u] = i++;
   for (auto u : ks)
-    x.forEachEdgeKey(u, [&](auto v) { a.push_back(T(ids[v])); });
+    x.forEachEdgeKey(u, [&](auto v) { a.push_back(ids[v]); });
   return a;
 }
 template <class G, class T>
@@ -65,3 +85,199 @@ inline auto destinationIndices(const G& x) {
   using K = typename G::key_type;
   return destinationIndicesAs(x, K());
 }
+
+
+// Edges of a slice of vertices are first touched by the thread that owns it.
+template <class G, class J, class T>
+auto destinationIndicesAsOmp(const G& x, const J& ks, const vector<T>& vfrom) {
+  size_t N = ks.size();
+  vector<T> ids(x.span());
+  auto a = createVectorOmp<T>(size_t(vfrom[N]));
+  #pragma omp parallel for schedule(auto)
+  for (size_t j=0; j<N; ++j)
+    ids[ks[j]] = T(j);
+  forEachSliceOmp(N, [&](size_t i, size_t I) {
+    for (size_t j=i; j<I; ++j) {
+      size_t k = size_t(vfrom[j]);
+      x.forEachEdgeKey(ks[j], [&](auto v) { a[k++] = ids[v]; });
+    }
+  });
+  return a;
+}
+
+
+
+
+// SLACK-CSR
+// ---------
+// CSR of a transpose graph, with free slots at the end of each row.
+// Free slots point to a null vertex (none), which must have zero factor.
+// Vertices keep the index they were added with, so that a batch of edges
+// can be patched in place, instead of rebuilding from the graph.
+
+#define SLACK_CSR_MIN   4  // minimum free slots per row
+#define SLACK_CSR_RATIO 4  // free slots per row = degree / ratio
+
+
+template <class K=int>
+class SlackCsr {
+  // Data.
+  protected:
+  K N = 0;
+  vector<K> vkeys;    // vertex key at each index
+  vector<K> vids;     // index of each vertex key (-1 if absent)
+  vector<K> vdata;    // vertex data (out-degree)
+  vector<K> vdegree;  // used slots in each row (in-degree)
+  vector<K> vfrom;    // row offsets (span+1)
+  vector<K> efrom;    // source index of each edge (none if free)
+
+
+  // Property operations.
+  public:
+  inline K order() const noexcept { return N; }
+  inline K span()  const noexcept { return K(vfrom.size()-1); }
+  inline K none()  const noexcept { return span()-1; }
+  inline size_t size() const noexcept { return sumValues(vdegree, 0, N, size_t()); }
+
+
+  // Access operations.
+  public:
+  inline const vector<K>& vertexKeys()         const noexcept { return vkeys; }
+  inline const vector<K>& vertexData()         const noexcept { return vdata; }
+  inline const vector<K>& sourceOffsets()      const noexcept { return vfrom; }
+  inline const vector<K>& destinationIndices() const noexcept { return efrom; }
+  inline bool hasVertex(K u) const noexcept { return u>=0 && size_t(u)<vids.size() && vids[u]>=0; }
+  inline K    index(K u)     const noexcept { return hasVertex(u)? vids[u] : K(-1); }
+
+
+  // Update operations.
+  protected:
+  inline K slack(K d) const noexcept {
+    return max(K(SLACK_CSR_MIN), d/SLACK_CSR_RATIO);
+  }
+
+  // Reorganize rows with fresh slack, and room for at least S vertices.
+  void compact(K S) {
+    K C = max(S, span()-1), i = 0;
+    vector<K> vfrom1(C+2);
+    for (K v=0; v<C; ++v) {
+      vfrom1[v] = i;
+      i += v<N? vdegree[v] + slack(vdegree[v]) : SLACK_CSR_MIN;
+    }
+    vfrom1[C] = vfrom1[C+1] = i;
+    vector<K> efrom1(i, C);
+    #pragma omp parallel for schedule(dynamic, 2048)
+    for (K v=0; v<N; ++v) {
+      for (K j=0; j<vdegree[v]; ++j)
+        efrom1[vfrom1[v]+j] = efrom[vfrom[v]+j];
+    }
+    vdata.resize(C+1);
+    vdegree.resize(C+1);
+    swap(vfrom, vfrom1);
+    swap(efrom, efrom1);
+  }
+
+  public:
+  inline void reserve(K S) {
+    if (S+1 > span()) compact(max(S, 2*N));
+  }
+
+  inline bool addVertex(K u, K d=K()) {
+    if (hasVertex(u)) return false;
+    if (N+1 >= span()) compact(max(N+1, 2*N));
+    if (size_t(u) >= vids.size()) vids.resize(u+1, K(-1));
+    vids[u] = N;
+    vkeys.push_back(u);
+    vdata[N]   = d;
+    vdegree[N] = 0;
+    ++N;
+    return true;
+  }
+
+  // Add edge u -> v (of the original graph), which must not already exist.
+  inline bool addEdge(K u, K v) {
+    addVertex(u); addVertex(v);
+    K iu = vids[u], iv = vids[v];
+    if (vfrom[iv]+vdegree[iv] >= vfrom[iv+1]) compact(span()-1);
+    efrom[vfrom[iv] + vdegree[iv]++] = iu;
+    ++vdata[iu];
+    return true;
+  }
+
+  // Remove edge u -> v (of the original graph).
+  inline bool removeEdge(K u, K v) {
+    if (!hasVertex(u) || !hasVertex(v)) return false;
+    K iu = vids[u], iv = vids[v];
+    K jb = vfrom[iv], je = jb + vdegree[iv];
+    for (K j=jb; j<je; ++j) {
+      if (efrom[j] != iu) continue;
+      efrom[j]    = efrom[je-1];
+      efrom[je-1] = none();
+      --vdegree[iv];
+      --vdata[iu];
+      return true;
+    }
+    return false;
+  }
+
+  // Load transpose graph (with vertex-data=out-degree), in order of vertices ks.
+  template <class H, class J>
+  void assignFrom(const H& xt, const J& ks) {
+    clear();
+    for (auto v : ks) {
+      if (size_t(v) >= vids.size()) vids.resize(v+1, K(-1));
+      vids[v] = N++;
+      vkeys.push_back(K(v));
+    }
+    K C = N + slack(N), i = 0;
+    vdata.assign(C+1, K());
+    vdegree.assign(C+1, K());
+    vfrom.resize(C+2);
+    for (K v=0; v<C; ++v) {
+      if (v<N) vdata[v]   = xt.vertexValue(vkeys[v]);
+      if (v<N) vdegree[v] = xt.degree(vkeys[v]);
+      vfrom[v] = i;
+      i += v<N? vdegree[v] + slack(vdegree[v]) : SLACK_CSR_MIN;
+    }
+    vfrom[C] = vfrom[C+1] = i;
+    efrom.assign(i, C);
+    #pragma omp parallel for schedule(dynamic, 2048)
+    for (K v=0; v<N; ++v) {
+      K j = vfrom[v];
+      xt.forEachEdgeKey(vkeys[v], [&](auto u) { efrom[j++] = vids[u]; });
+    }
+  }
+
+  inline bool clear() noexcept {
+    N = 0;
+    vkeys.clear();
+    vids.clear();
+    vdata.assign(1, K());
+    vdegree.assign(1, K());
+    vfrom.assign(2, K());
+    efrom.clear();
+    return true;
+  }
+
+
+  // Lifetime operations.
+  public:
+  SlackCsr() { clear(); }
+};
+
+
+
+
+// SLACK-CSR-*
+// -----------
+
+template <class H, class J>
+inline auto slackCsr(const H& xt, const J& ks) {
+  using K = typename H::key_type;
+  SlackCsr<K> a; a.assignFrom(xt, ks);
+  return a;
+}
+template <class H>
+inline auto slackCsr(const H& xt) {
+  return slackCsr(xt, xt.vertexKeys());
+}
@@ -7,12 +7,15 @@
 #include "_main.hxx"
 #include "vertices.hxx"
 #include "components.hxx"
+#include "bfs.hxx"
 
 using std::iterator_traits;
 using std::vector;
 using std::unordered_set;
 using std::make_pair;
 using std::max;
+using std::min;
+using std::pair;
 
 
 
@@ -20,14 +23,15 @@ using std::max;
 // ADJUST-RANKS
 // ------------
 // For calculating inital ranks for incremental/dynamic pagerank.
+// Old vertices are marked in a flag vector (keys are below span of a).
 
 template <class T, class J>
 void adjustRanks(vector<T>& a, const vector<T>& r, const J& Kx, const J& Ky, T radd, T rmul, T rset) {
-  using I = decltype(Kx.begin());
-  using K = typename iterator_traits<I>::value_type;
-  unordered_set<K> Sx(Kx.begin(), Kx.end());
+  vector<char> old(a.size());
+  for (auto u : Kx)
+    if (size_t(u)<old.size()) old[u] = 1;
   for (auto u : Ky)
-    a[u] = Sx.count(u)==0? rset : (r[u]+radd)*rmul;  // vertex new/old
+    a[u] = old[u]? (r[u]+radd)*rmul : rset;  // vertex old/new
 }
 template <class T, class J>
 auto adjustRanks(size_t N, const vector<T>& r, const J& ks0, const J& ks1, T radd, T rmul, T rset) {
@@ -36,6 +40,21 @@ auto adjustRanks(size_t N, const vector<T>& r, const J& ks0, const J& ks1, T rad
 }
 
 
+template <class T, class K>
+void adjustRanksOmp(vector<T>& a, const vector<T>& r, const vector<K>& Kx, const vector<K>& Ky, T radd, T rmul, T rset) {
+  vector<char> old(a.size());
+  size_t X = Kx.size(), Y = Ky.size();
+  #pragma omp parallel for schedule(static, 2048)
+  for (size_t i=0; i<X; ++i)
+    if (size_t(Kx[i])<old.size()) old[Kx[i]] = 1;
+  #pragma omp parallel for schedule(static, 2048)
+  for (size_t i=0; i<Y; ++i) {
+    K u = Ky[i];
+    a[u] = old[u]? (r[u]+radd)*rmul : rset;
+  }
+}
+
+
 
 
 // CHANGED-VERTICES
@@ -200,18 +219,87 @@ auto dynamicOutVertices(const G& x, const G& y) {
 
 
 
+// PARTITION-MARKED (OMP)
+// ----------------------
+// Keys (0..S) marked first, then the unmarked ones (keys, no. marked).
+
+template <class K, class FE, class FM>
+auto partitionMarkedOmp(K S, FE fe, FM fm) {
+  int  T = omp_get_max_threads();
+  K    B = ceilDiv(S, K(T));
+  vector<size_t> na(T+1), nb(T+1);
+  #pragma omp parallel for schedule(static, 1)
+  for (int t=0; t<T; ++t) {
+    for (K u=K(t)*B, U=min(S, K(t+1)*B); u<U; ++u) {
+      if (!fe(u)) continue;
+      if (fm(u)) ++na[t+1];
+      else ++nb[t+1];
+    }
+  }
+  for (int t=0; t<T; ++t) {
+    na[t+1] += na[t];
+    nb[t+1] += nb[t];
+  }
+  size_t n = na[T];
+  vector<K> a(n + nb[T]);
+  #pragma omp parallel for schedule(static, 1)
+  for (int t=0; t<T; ++t) {
+    size_t i = na[t], j = n + nb[t];
+    for (K u=K(t)*B, U=min(S, K(t+1)*B); u<U; ++u) {
+      if (!fe(u)) continue;
+      if (fm(u)) a[i++] = u;
+      else a[j++] = u;
+    }
+  }
+  return make_pair(a, n);
+}
+
+
+
+
+// DYNAMIC-VERTICES-FROM (OMP)
+// ---------------------------
+// Find affected, unaffected vertices from known changed vertices (vertices, no. affected).
+// Changed vertices are usually returned by a batch update (see applyBatchU).
+// Reachability is found with parallel BFS, optionally only up to given depth (D >= 0).
+// Dead ends do not affect all vertices here; a change in their ranks only
+// scales all ranks uniformly, which the caller handles (see pagerankSeq.hxx).
+
+template <class G, class J>
+void affectedVerticesFromMarkOmp(vector<char>& vis, const G& y, const J& ks, int D=-1) {
+  bfsMarkOmpLoop(vis, y, ks, D);
+}
+
+
+template <class G, class FA>
+auto dynamicVerticesByMarkOmp(const G& y, FA fa) {
+  using K = typename G::key_type;
+  auto vis = createContainer(y, char()); fa(vis);
+  auto fe  = [&](K u) { return y.hasVertex(u); };
+  auto fm  = [&](K u) { return vis[u]!=0; };
+  return partitionMarkedOmp(K(y.span()), fe, fm);
+}
+
+template <class G, class J>
+auto dynamicVerticesFromOmp(const G& y, const J& ks, int D=-1) {
+  return dynamicVerticesByMarkOmp(y, [&](auto& vis) { affectedVerticesFromMarkOmp(vis, y, ks, D); });
+}
+
+
+
+
 // CHANGED-COMPONENTS
 // ------------------
 // Find components with edges added/removed.
 
 template <class G, class K, class F>
 void changedComponentIndicesDo(const G& x, const G& y, const vector2d<K>& cs, F fn) {
-  for (K i=0; i<cs.size(); ++i)
+  for (K i=0, I=K(cs.size()); i<I; ++i)
     if (!componentsEqual(x, cs[i], y, cs[i])) fn(i);
 }
 template <class G, class H, class K, class F>
 void changedComponentIndicesDo(const G& x, const H& xt, const G& y, const H& yt, const vector2d<K>& cs, F fn) {
-  for (K i=0; i<cs.size(); ++i)
+  for (K i=0, I=K(cs.size()); i<I; ++i)
     if (!componentsEqual(x, xt, cs[i], y, yt, cs[i])) fn(i);  // both ways
 }
 template <class G, class H, class K, class F>
@@ -254,7 +342,7 @@ template <class G, class K>
 bool hasAffectedDeadEnd(const G& x, const G& y, const vector2d<K>& cs, const vector<bool>& vis) {
   for (auto u : x.vertexKeys())
     if (isDeadEnd(x, u) && !y.hasVertex(u)) return true;
-  for (K i=0; i<cs.size(); ++i) {
+  for (K i=0, I=K(cs.size()); i<I; ++i) {
     if (!vis[i]) continue;
     for (auto u : cs[i])
       if (isDeadEnd(y, u)) return true;
@@ -282,8 +370,8 @@ bool affectedOutComponentIndicesMark(vector<bool>& vis, const G& x, const G& y,
 
 template <class G, class K, class F>
 void affectedComponentIndicesDoInt(const G& x, const G& y, const vector2d<K>& cs, const vector<bool>& vis, F fn) {
-  if (hasAffectedDeadEnd(x, y, cs, vis)) { for (K i=0; i<cs.size(); ++i) fn(i); }
-  else { for (K i=0; i<cs.size(); ++i) { if (vis[i]) fn(i); } }
+  if (hasAffectedDeadEnd(x, y, cs, vis)) { for (K i=0, I=K(cs.size()); i<I; ++i) fn(i); }
+  else { for (K i=0, I=K(cs.size()); i<I; ++i) { if (vis[i]) fn(i); } }
 }
 template <class G, class H, class K, class B, class F>
 void affectedComponentIndicesDo(const G& x, const H& xt, const G& y, const H& yt, const vector2d<K>& cs, const B& b, F fn) {
@@ -333,9 +421,9 @@ auto dynamicComponentIndicesByMark(const G& y, const vector2d<K>& cs, FA fa) {
   auto vis = createContainer(y, bool());
   if(fa(vis)) return make_pair(rangeVector(K(cs.size())), cs.size());
   vector<K> a; size_t n = 0;
-  for (K i=0; i<cs.size(); ++i)
+  for (K i=0, I=K(cs.size()); i<I; ++i)
     if (vis[i]) { a.push_back(i); ++n; }
-  for (K i=0; i<cs.size(); ++i)
+  for (K i=0, I=K(cs.size()); i<I; ++i)
     if (!vis[i]) a.push_back(i);
   return make_pair(a, n);
 }
@@ -368,3 +456,39 @@ auto dynamicOutComponentIndices(const G& x, const H& xt, const G& y, const H& yt
     return affectedOutComponentIndicesDo(vis, x, xt, y, yt, cs, b);
   });
 }
+
+
+
+
+
+// DYNAMIC-COMPONENTS-FROM (OMP)
+// -----------------------------
+// Find affected, unaffected components from known changed vertices (components, no. affected).
+// Reachability is found with parallel BFS, optionally only up to given depth (D >= 0).
+// Component of each vertex (c) is usually kept up to date (see DynamicComponents).
+// Dead ends are left to the caller, as above.
+
+template <class K, class B, class J>
+void affectedComponentIndicesFromMarkOmp(vector<char>& vis, const vector<K>& c, const B& b, const J& ks, int D=-1) {
+  vector<K> is;
+  for (auto u : ks)
+    is.push_back(c[u]);
+  sortValues(is); is.resize(uniqueValues(is));
+  bfsMarkOmpLoop(vis, b, is, D);
+}
+
+
+template <class B, class K, class FA>
+auto dynamicComponentIndicesByMarkOmp(const B& b, const vector2d<K>& cs, FA fa) {
+  auto vis = createContainer(b, char()); fa(vis);
+  auto fe  = [&](K i) { return true; };
+  auto fm  = [&](K i) { return vis[i]!=0; };
+  return partitionMarkedOmp(K(cs.size()), fe, fm);
+}
+
+template <class K, class B, class J>
+auto dynamicComponentIndicesFromOmp(const vector2d<K>& cs, const vector<K>& c, const B& b, const J& ks, int D=-1) {
+  return dynamicComponentIndicesByMarkOmp(b, cs, [&](auto& vis) {
+    affectedComponentIndicesFromMarkOmp(vis, c, b, ks, D);
+  });
+}
@@ -0,0 +1,412 @@
+#pragma once
+#include <utility>
+#include <vector>
+#include <queue>
+#include <algorithm>
+#include <functional>
+#include "_main.hxx"
+#include "components.hxx"
+#include "sort.hxx"
+#include "transpose.hxx"
+
+using std::pair;
+using std::vector;
+using std::priority_queue;
+using std::greater;
+using std::binary_search;
+using std::sort;
+using std::min;
+using std::max;
+
+
+
+
+// DYNAMIC-COMPONENTS
+// ------------------
+// Strongly Connected Components (SCC), with their blockgraph and levels,
+// maintained under batches of edge deletions and insertions.
+// Insertions merge components along new cycles, using a dynamic topological
+// order of components (Pearce-Kelly). Deletions within a component re-split
+// only that component. Component slots are reused, so exported components
+// and blockgraph are compacted (in topological order).
+
+template <class G>
+class DynamicComponents {
+  using K = typename G::key_type;
+  using E = pair<K, K>;
+
+  // Data.
+  protected:
+  size_t      C = 0;  // no. of components
+  vector<K>   cid;    // component of each vertex (-1 if none)
+  vector2d<K> cs;     // vertices of each component (empty if free)
+  vector<K>   cfree;  // free component slots
+  G           b, bt;  // blockgraph, and its transpose
+  vector<K>   ord;    // topological position of each component
+  vector<K>   at;     // component at each position (-1 if none)
+  vector<K>   lv;     // level of each component
+  vector<char> cmark; // component marks (search, queue)
+  vector<K>    vloc;  // local index of vertex (re-split)
+
+
+  // Property operations.
+  public:
+  inline size_t size() const noexcept { return C; }
+  inline K componentOf(K u) const noexcept { return size_t(u) < cid.size()? cid[u] : K(-1); }
+
+
+  // Component operations.
+  protected:
+  K addComponent() {
+    K c;
+    if (!cfree.empty()) { c = cfree.back(); cfree.pop_back(); }
+    else {
+      c = K(cs.size());
+      cs.emplace_back();
+      ord.push_back(K());
+      lv.push_back(K());
+      cmark.push_back(0);
+      b.addVertex(c);
+      bt.addVertex(c);
+    }
+    ord[c] = K(at.size());
+    at.push_back(c);
+    lv[c]  = K();
+    ++C;
+    return c;
+  }
+
+  inline void addBlockEdge(K c, K d) {
+    if (b.hasEdge(c, d)) return;
+    b.addEdge(c, d);
+    bt.addEdge(d, c);
+  }
+
+  void removeBlockEdges(K c) {
+    b .forEachEdgeKey(c, [&](auto d) { bt.removeEdge(d, c); });
+    bt.forEachEdgeKey(c, [&](auto d) { b .removeEdge(d, c); });
+    b .removeEdges(c);
+    bt.removeEdges(c);
+  }
+
+  // Is there still an edge from component c to d (scan smaller side)?
+  template <class H>
+  bool hasEdgeBetween(const G& y, const H& yt, K c, K d) const {
+    bool has = false;
+    if (cs[c].size() <= cs[d].size()) {
+      for (K u : cs[c])
+        y.forEachEdgeKey(u, [&](auto v) { if (cid[v]==d) has = true; });
+    }
+    else {
+      for (K v : cs[d])
+        yt.forEachEdgeKey(v, [&](auto u) { if (cid[u]==c) has = true; });
+    }
+    return has;
+  }
+
+
+  // Update operations.
+  protected:
+  // Split component c into its SCCs (Tarjan, on induced subgraph).
+  // Blockgraph edges due to inserted edges are left for insertBlockEdge().
+  template <class H>
+  bool splitComponent(const G& y, const H& yt, K c, const vector<E>& ins, vector<K>& touched) {
+    vector<K> ks = cs[c]; K n = K(ks.size());
+    vector<K> off(n+1), adj;
+    for (K i=0; i<n; ++i)
+      vloc[ks[i]] = i;
+    for (K i=0; i<n; ++i) {
+      y.forEachEdgeKey(ks[i], [&](auto v) { if (cid[v]==c) adj.push_back(vloc[v]); });
+      off[i+1] = K(adj.size());
+    }
+    for (K u : ks)
+      vloc[u] = K(-1);
+    vector2d<K> ss;
+    vector<K> idx(n, K(-1)), low(n), eit(n), stk, cstk;
+    vector<char> on(n);
+    K t = 0;
+    for (K s=0; s<n; ++s) {
+      if (idx[s]!=K(-1)) continue;
+      idx[s] = low[s] = t++; eit[s] = off[s];
+      stk.push_back(s); on[s] = 1; cstk.push_back(s);
+      while (!cstk.empty()) {
+        K u = cstk.back();
+        if (eit[u] < off[u+1]) {
+          K v = adj[eit[u]++];
+          if (idx[v]==K(-1)) {
+            idx[v] = low[v] = t++; eit[v] = off[v];
+            stk.push_back(v); on[v] = 1; cstk.push_back(v);
+          }
+          else if (on[v]) low[u] = min(low[u], idx[v]);
+          continue;
+        }
+        cstk.pop_back();
+        if (!cstk.empty()) low[cstk.back()] = min(low[cstk.back()], low[u]);
+        if (low[u]!=idx[u]) continue;
+        ss.emplace_back(); K v;
+        do {
+          v = stk.back(); stk.pop_back(); on[v] = 0;
+          ss.back().push_back(ks[v]);
+        } while (v!=u);
+      }
+    }
+    if (ss.size()<=1) return false;
+    b.forEachEdgeKey(c, [&](auto d) { touched.push_back(d); });
+    removeBlockEdges(c);
+    vector<K> sc;
+    for (size_t i=0; i<ss.size(); ++i) {
+      K s = i==0? c : addComponent();
+      for (K u : ss[i])
+        cid[u] = s;
+      cs[s] = move(ss[i]);
+      sc.push_back(s);
+    }
+    auto isNew = [&](K u, K v) { return binary_search(ins.begin(), ins.end(), E(u, v)); };
+    for (K s : sc) {
+      for (K u : cs[s]) {
+        y .forEachEdgeKey(u, [&](auto v) { if (cid[v]!=s && !isNew(u, v)) addBlockEdge(s, cid[v]); });
+        yt.forEachEdgeKey(u, [&](auto v) { if (cid[v]!=s && !isNew(v, u)) addBlockEdge(cid[v], s); });
+      }
+      touched.push_back(s);
+      b.forEachEdgeKey(s, [&](auto d) { touched.push_back(d); });
+    }
+    return true;
+  }
+
+  // Renumber topological order from scratch (after splits).
+  void reorderComponents() {
+    auto bks = topologicalSort(b);
+    at.clear();
+    for (K c : bks) {
+      if (cs[c].empty()) continue;
+      ord[c] = K(at.size());
+      at.push_back(c);
+    }
+  }
+
+  // Drop free positions in topological order.
+  void compactOrder() {
+    size_t j = 0;
+    for (size_t i=0; i<at.size(); ++i) {
+      K c = at[i];
+      if (c==K(-1)) continue;
+      ord[c] = K(j);
+      at[j++] = c;
+    }
+    at.resize(j);
+  }
+
+  // Add blockgraph edge c -> d (Pearce-Kelly); merge components on a new cycle.
+  void insertBlockEdge(K c, K d, vector<K>& touched) {
+    if (c==d || b.hasEdge(c, d)) return;
+    K lb = ord[d], ub = ord[c];
+    if (lb > ub) { addBlockEdge(c, d); touched.push_back(d); return; }
+    // Find affected region: forward from d, backward from c.
+    vector<K> fs {d}, bs {c}; cmark[d] |= 1; cmark[c] |= 2;
+    for (size_t i=0; i<fs.size(); ++i) {
+      b.forEachEdgeKey(fs[i], [&](auto w) {
+        if ((cmark[w] & 1) || ord[w] > ub) return;
+        cmark[w] |= 1; fs.push_back(w);
+      });
+    }
+    for (size_t i=0; i<bs.size(); ++i) {
+      bt.forEachEdgeKey(bs[i], [&](auto w) {
+        if ((cmark[w] & 2) || ord[w] < lb) return;
+        cmark[w] |= 2; bs.push_back(w);
+      });
+    }
+    bool cyc = cmark[c] & 1;
+    // Split region into before (B), cycle (Z), after (F).
+    vector<K> pool, zs, bo, fo;
+    for (K w : bs) {
+      pool.push_back(ord[w]);
+      if (cmark[w]==3) zs.push_back(w);
+      else bo.push_back(w);
+    }
+    for (K w : fs) {
+      if (cmark[w]==3) continue;
+      pool.push_back(ord[w]);
+      fo.push_back(w);
+    }
+    auto fl = [&](K p, K q) { return ord[p] < ord[q]; };
+    sort(pool.begin(), pool.end());
+    sort(bo.begin(), bo.end(), fl);
+    sort(fo.begin(), fo.end(), fl);
+    for (K p : pool)
+      at[p] = K(-1);
+    size_t P = pool.size(), i = 0;
+    for (K w : bo) { ord[w] = pool[i++]; at[ord[w]] = w; }
+    if (cyc) {
+      K m = zs[0];
+      for (K z : zs)
+        if (cs[z].size() > cs[m].size()) m = z;
+      ord[m] = pool[i]; at[ord[m]] = m;
+      mergeComponents(zs, m);
+      touched.push_back(m);
+      b.forEachEdgeKey(m, [&](auto w) { touched.push_back(w); });
+    }
+    else {
+      addBlockEdge(c, d);
+      touched.push_back(d);
+    }
+    i = P - fo.size();
+    for (K w : fo) { ord[w] = pool[i++]; at[ord[w]] = w; }
+    for (K w : fs) cmark[w] = 0;
+    for (K w : bs) cmark[w] = 0;
+  }
+
+  // Merge components zs (marked 3) into m.
+  void mergeComponents(const vector<K>& zs, K m) {
+    for (K z : zs) {
+      if (z==m) continue;
+      for (K u : cs[z]) {
+        cid[u] = m;
+        cs[m].push_back(u);
+      }
+      b .forEachEdgeKey(z, [&](auto w) { bt.removeEdge(w, z); if (cmark[w]!=3) addBlockEdge(m, w); });
+      bt.forEachEdgeKey(z, [&](auto w) { b .removeEdge(w, z); if (cmark[w]!=3) addBlockEdge(w, m); });
+      b .removeEdges(z);
+      bt.removeEdges(z);
+      cs[z].clear();
+      cfree.push_back(z);
+      --C;
+    }
+  }
+
+  // Update levels of touched components, and their successors (in topological order).
+  void updateLevels(const vector<K>& touched) {
+    priority_queue<E, vector<E>, greater<E>> pq;
+    auto push = [&](K c) {
+      if (cs[c].empty() || (cmark[c] & 4)) return;
+      cmark[c] |= 4; pq.push({ord[c], c});
+    };
+    for (K c : touched)
+      push(c);
+    while (!pq.empty()) {
+      K c = pq.top().second; pq.pop();
+      cmark[c] &= ~4;
+      K l = K();
+      bt.forEachEdgeKey(c, [&](auto p) { l = max(l, K(lv[p]+1)); });
+      if (l==lv[c]) continue;
+      lv[c] = l;
+      b.forEachEdgeKey(c, push);
+    }
+  }
+
+  public:
+  // Find components of a graph from scratch.
+  template <class H>
+  void assignFrom(const G& x, const H& xt) {
+    cs = ::components(x, xt);
+    C  = cs.size();
+    cfree.clear();
+    cid.assign(x.span(), K(-1));
+    for (K i=0; i<K(C); ++i) {
+      for (K u : cs[i])
+        cid[u] = i;
+    }
+    b  = ::blockgraph(x, cs);
+    bt = transpose(b);
+    lv = levelwiseGroupIndices(b, bt);
+    ord.resize(C);
+    at.resize(C);
+    for (K i=0; i<K(C); ++i)
+      ord[i] = at[i] = i;
+    cmark.assign(C, 0);
+    vloc.assign(x.span(), K(-1));
+  }
+
+  // Update with a batch applied to graph (see applyBatchU).
+  // @param y   updated graph
+  // @param yt  updated transpose
+  // @param del removed edges (applied)
+  // @param ins added edges (applied, sorted)
+  template <class H>
+  void update(const G& y, const H& yt, const vector<E>& del, const vector<E>& ins) {
+    vector<K> touched, splits;
+    cid.resize(y.span(), K(-1));
+    vloc.resize(y.span(), K(-1));
+    // Add new vertices as singleton components.
+    for (const auto& [u, v] : ins) {
+      for (K w : {u, v}) {
+        if (cid[w]!=K(-1)) continue;
+        K c = addComponent();
+        cs[c].push_back(w);
+        cid[w] = c;
+        touched.push_back(c);
+      }
+    }
+    // Re-split components which lost an internal edge.
+    for (const auto& [u, v] : del)
+      if (cid[u]==cid[v]) splits.push_back(cid[u]);
+    sortValues(splits); splits.resize(uniqueValues(splits));
+    bool split = false;
+    for (K c : splits)
+      split |= splitComponent(y, yt, c, ins, touched);
+    if (split) reorderComponents();
+    // Remove blockgraph edges no longer present.
+    for (const auto& [u, v] : del) {
+      K c = cid[u], d = cid[v];
+      if (c==d || !b.hasEdge(c, d) || hasEdgeBetween(y, yt, c, d)) continue;
+      b .removeEdge(c, d);
+      bt.removeEdge(d, c);
+      touched.push_back(d);
+    }
+    // Add blockgraph edges, merging components on new cycles.
+    for (const auto& [u, v] : ins)
+      insertBlockEdge(cid[u], cid[v], touched);
+    b.correct();
+    bt.correct();
+    updateLevels(touched);
+    if (at.size() > 2*C) compactOrder();
+  }
+
+
+  // Export operations.
+  public:
+  // Get compacted index of each component slot.
+  vector<K> componentIndices() const {
+    vector<K> a(cs.size(), K(-1)); K i = 0;
+    for (K c : at)
+      if (c!=K(-1)) a[c] = i++;
+    return a;
+  }
+
+  vector<K> componentIds() const {
+    auto is = componentIndices();
+    vector<K> a(cid.size());
+    for (size_t u=0; u<cid.size(); ++u)
+      a[u] = cid[u]==K(-1)? K() : is[cid[u]];
+    return a;
+  }
+
+  vector2d<K> components() const {
+    vector2d<K> a;
+    for (K c : at)
+      if (c!=K(-1)) a.push_back(cs[c]);
+    return a;
+  }
+
+  G blockgraph() const { return exportGraph(b); }
+  G blockgraphTranspose() const { return exportGraph(bt); }
+
+  vector<K> levels() const {
+    vector<K> a;
+    for (K c : at)
+      if (c!=K(-1)) a.push_back(lv[c]);
+    return a;
+  }
+
+  protected:
+  G exportGraph(const G& x) const {
+    auto is = componentIndices(); G a;
+    for (K i=0; i<K(C); ++i)
+      a.addVertex(i);
+    for (K c : at) {
+      if (c==K(-1)) continue;
+      x.forEachEdgeKey(c, [&](auto d) { a.addEdge(is[c], is[d]); });
+    }
+    a.correct();
+    return a;
+  }
+};
@@ -1,5 +1,6 @@
 #pragma once
 #include "_main.hxx"
+#include "perfCounters.hxx"
 #include "Graph.hxx"
 #include "mtx.hxx"
 #include "snap.hxx"
@@ -10,8 +11,11 @@
 #include "duplicate.hxx"
 #include "transpose.hxx"
 #include "dfs.hxx"
+#include "bfs.hxx"
 #include "depth.hxx"
 #include "components.hxx"
+#include "reorder.hxx"
+#include "dynamicComponents.hxx"
 #include "sort.hxx"
 #include "deadEnds.hxx"
 #include "selfLoop.hxx"
@@ -24,6 +28,10 @@
 #include "pagerankMonolithicSeq.hxx"
 #include "pagerankMonolithicOmp.hxx"
 #include "pagerankMonolithicBarrierfreeOmp.hxx"
+#include "pagerankMonolithicStealingOmp.hxx"
+#include "pagerankMonolithicFrontierOmp.hxx"
+#include "pagerankMonolithicSimdOmp.hxx"
 #include "pagerankLevelwiseSeq.hxx"
 #include "pagerankLevelwiseOmp.hxx"
 #include "pagerankLevelwiseBarrierfreeOmp.hxx"
+#include "pagerankStream.hxx"
@@ -2,7 +2,10 @@
 #include <vector>
 #include <utility>
 #include "_main.hxx"
+#include "csr.hxx"
 #include "components.hxx"
+#include "sort.hxx"
+#include "dynamic.hxx"
 
 using std::vector;
 using std::move;
@@ -21,9 +24,12 @@ struct PagerankOptions {
   int  toleranceNorm;
   T    tolerance;
   int  maxIterations;
+  int  maxDepth;  // reachability depth of affected vertices (dynamic, -1 = any)
+  int  reorder;   // vertex order within components/levels (VertexOrder)
+  bool frontier;  // update only vertices with large residual (barrier-free, dynamic)
 
-  PagerankOptions(int repeat=1, bool splitComponents=false, T damping=0.85, int toleranceNorm=1, T tolerance=1e-6, int maxIterations=500) :
-  repeat(repeat), splitComponents(splitComponents), damping(damping), toleranceNorm(toleranceNorm), tolerance(tolerance), maxIterations(maxIterations) {}
+  PagerankOptions(int repeat=1, bool splitComponents=false, T damping=0.85, int toleranceNorm=1, T tolerance=1e-6, int maxIterations=500, int maxDepth=-1, int reorder=0, bool frontier=false) :
+  repeat(repeat), splitComponents(splitComponents), damping(damping), toleranceNorm(toleranceNorm), tolerance(tolerance), maxIterations(maxIterations), maxDepth(maxDepth), reorder(reorder), frontier(frontier) {}
 };
 
 
@@ -32,11 +38,19 @@ struct PagerankOptions {
 // PAGERANK-RESULT
 // ---------------
 
+// Work done by each thread (only reported by barrier-free engines).
+struct PagerankThreadWork {
+  vector<float> iterations;  // equivalent iterations over own vertices
+  vector<float> idleTime;    // time spent waiting for other threads (ms)
+};
+
+
 template <class T>
 struct PagerankResult {
   vector<T> ranks;
   int   iterations;
   float time;
+  PagerankThreadWork threads;
 
   PagerankResult(vector<T>&& ranks, int iterations=0, float time=0) :
   ranks(ranks), iterations(iterations), time(time) {}
@@ -68,6 +82,12 @@ struct PagerankData {
   vector2d<K> components;
   G blockgraph;
   G blockgraphTranspose;
+  vector<K> levels;  // level of each component (optional)
+  const SlackCsr<K> *csr = nullptr;  // persistent CSR of transpose (optional)
+  const vector<K> *changed = nullptr;  // vertices touched by batch update (optional)
+  vector<K> componentIds;  // component of each vertex (optional)
+  const vector<K> *verticesOld = nullptr;  // vertex keys before batch, if graph updated in place (optional)
+  const vector<K> *deadEndsOld = nullptr;  // dead ends before batch (with verticesOld)
 };
 
 template <class G, class K>
@@ -80,7 +100,44 @@ auto blockgraphTransposeD(const G& b, const PagerankData<G> *D) {
   return D? D->blockgraphTranspose : transpose(b);
 }
 
+template <class G, class H>
+auto levelwiseGroupIndicesD(const G& b, const H& bt, const PagerankData<G> *D) {
+  return D && !D->levels.empty()? D->levels : levelwiseGroupIndices(b, bt);
+}
+
+template <class G, class H, class K>
+auto levelwiseGroupedComponentsD(const vector2d<K>& cs, const G& b, const H& bt, const PagerankData<G> *D) {
+  if (!D || D->levels.empty()) return levelwiseGroupedComponentsFrom(cs, b, bt);
+  const auto& lv = D->levels; vector2d<K> a;
+  auto bgs = groupValuesVector(rangeVector(K(cs.size())), [&](K i) { return lv[i]; });
+  for (const auto& g : bgs)
+    a.push_back(joinAtVector(cs, g));
+  return a;
+}
+
 template <class G, class H>
 auto componentsD(const G& x, const H& xt, const PagerankData<G> *D) {
   return D? D->components : components(x, xt);
 }
+
+// Known changed vertices avoid a scan of both graphs (and allow parallel search).
+template <class G, class H, class T>
+auto dynamicInVerticesD(const G& x, const H& xt, const G& y, const H& yt, const PagerankOptions<T>& o, const PagerankData<G> *D) {
+  if (D && D->changed) return dynamicVerticesFromOmp(y, *D->changed, o.maxDepth);
+  return dynamicInVertices(x, xt, y, yt);
+}
+
+template <class G, class H, class K, class B, class T>
+auto dynamicInComponentIndicesD(const G& x, const H& xt, const G& y, const H& yt, const vector2d<K>& cs, const B& b, const PagerankOptions<T>& o, const PagerankData<G> *D) {
+  if (D && D->changed && !D->componentIds.empty()) return dynamicComponentIndicesFromOmp(cs, D->componentIds, b, *D->changed, o.maxDepth);
+  if (D && D->changed) return dynamicComponentIndicesFromOmp(cs, componentIdsOmp(y, cs), b, *D->changed, o.maxDepth);
+  return dynamicInComponentIndices(x, xt, y, yt, cs, b);
+}
+
+// Persistent CSR can be used only if vertex order does not matter.
+template <class G, class H, class T>
+auto slackCsrD(const H& xt, const PagerankOptions<T>& o, const PagerankData<G> *D) {
+  using K = typename G::key_type;
+  bool use = D && D->csr && !o.splitComponents && !o.reorder && D->csr->order()==xt.order();
+  return use? D->csr : (const SlackCsr<K>*) nullptr;
+}
@@ -13,6 +13,7 @@
 #include "pagerank.hxx"
 #include "pagerankOmp.hxx"
 #include "pagerankMonolithicOmp.hxx"
+#include "pagerankMonolithicBarrierfreeOmp.hxx"
 
 using std::vector;
 using std::swap;
@@ -27,16 +28,17 @@ using std::move;
 template <bool O, bool D, class K, class T, class J, bool F=false>
 int pagerankLevelwiseBarrierfreeOmpLoopU(vector<T>& a, vector<T>& r, vector<T>& c, const vector<T>& f, const vector<K>& vfrom, const vector<K>& efrom, const vector<K>& vdata, K i, const J& ns, K N, T p, T E, int L, int EF, K EI=K(), K EN=K()) {
   float l = 0;
-  // Cannot handle graph with dead-ends.
-  if (!O || D) return 0;
-  // Process each level unitl convergence.
+  if (!O) return 0;
+  // Dead ends only scale ranks uniformly, so levels are processed once, with
+  // teleport (1-p)/N, and ranks are normalized at the end.
   for (K n : ns) {
     if (n<=0) { i += -n; continue; }
     T    E1 = EF<=2? E*n/N : E;
-    int  l1 = pagerankMonolithicBarrierfreeOmpLoopU<O, D>(a, r, c, f, vfrom, efrom, vdata, i, n, N, p, E1, L, EF, F? i:K(), F? n:K());
+    float l1 = pagerankBarrierfreeOmpSlicesU<false>(a, r, f, vfrom, efrom, vdata, i, n, N, p, E1, L, EF, F? i:K(), F? n:K());
     l += l1 * float(n)/N;
     i += n;
   }
+  if (D) pagerankNormalizeOmpU(r, N);
   return int(l + 0.5f);
 }
 
@@ -59,10 +61,12 @@ PagerankResult<T> pagerankLevelwiseBarrierfreeOmp(const G& x, const H& xt, const
   const auto& cs = componentsD(x, xt, C);
   const auto& b  = blockgraphD(x, cs, C);
   const auto& bt = blockgraphTransposeD(b, C);
-  auto gs = levelwiseGroupedComponentsFrom(cs, b, bt);
+  auto gs = levelwiseGroupedComponentsD(cs, b, bt, C);
   auto ns = transformIterable(gs, [&](const auto& g) { return g.size(); });
   auto ks = joinValuesVector(gs);
-  return pagerankOmp(xt, ks, 0, ns, pagerankLevelwiseBarrierfreeOmpLoopU<O, D, K, T, decltype(ns), F>, q, o);
+  reorderSlicesU(ks, ns, x, xt, o.reorder);
+  vector<T> qs; auto qd = pagerankDynamicInitialOmpW<D>(qs, x, x, q, o.damping);
+  return pagerankOmp(xt, ks, 0, ns, pagerankLevelwiseBarrierfreeOmpLoopU<O, D, K, T, decltype(ns), F>, qd, o);
 }
 template <bool O, bool D, bool F, class G, class T=float>
 PagerankResult<T> pagerankLevelwiseBarrierfreeOmp(const G& x, const vector<T> *q=nullptr, const PagerankOptions<T>& o={}, const PagerankData<G> *C=nullptr) {
@@ -83,13 +87,15 @@ PagerankResult<T> pagerankLevelwiseBarrierfreeOmpDynamic(const G& x, const H& xt
   const auto& cs = componentsD(x, xt, C);
   const auto& b  = blockgraphD(x, cs, C);
   const auto& bt = blockgraphTransposeD(b, C);
-  auto gi = levelwiseGroupIndices(b, bt);
-  auto [is, n] = dynamicInComponentIndices(x, xt, y, yt, cs, b);  if (n==0) return PagerankResult<T>::initial(yt, q);
+  auto gi = levelwiseGroupIndicesD(b, bt, C);
+  auto [is, n] = dynamicInComponentIndicesD(x, xt, y, yt, cs, b, o, C);  if (n==0) return PagerankResult<T>::initial(yt, q);
   auto ig = groupValuesVector(sliceIterable(is, 0, n), [&](K i) { return gi[i]; });
   auto gs = joinAt2dVector(cs, ig);
   auto ns = transformIterable(gs, [&](const auto& g) { return g.size(); });
   auto ks = joinValuesVector(gs); joinAtU(ks, cs, sliceIterable(is, n));
-  return pagerankOmp(yt, ks, 0, ns, pagerankLevelwiseBarrierfreeOmpLoopU<O, D, K, T, decltype(ns), F>, q, o);
+  reorderSlicesU(ks, ns, y, yt, o.reorder);
+  vector<T> qs; auto qd = pagerankDynamicInitialOmpW<D>(qs, x, y, q, o.damping, C);
+  return pagerankOmp(yt, ks, 0, ns, pagerankLevelwiseBarrierfreeOmpLoopU<O, D, K, T, decltype(ns), F>, qd, o);
 }
 template <bool O, bool D, bool F, class G, class T=float>
 PagerankResult<T> pagerankLevelwiseBarrierfreeOmpDynamic(const G& x, const G& y, const vector<T> *q=nullptr, const PagerankOptions<T>& o={}, const PagerankData<G> *C=nullptr) {
@@ -27,17 +27,16 @@ using std::move;
 template <bool O, bool D, class K, class T, class J, bool F=false>
 int pagerankLevelwiseSeqLoopU(vector<T>& a, vector<T>& r, vector<T>& c, const vector<T>& f, const vector<K>& vfrom, const vector<K>& efrom, const vector<K>& vdata, K i, const J& ns, K N, T p, T E, int L, int EF, K EI=K(), K EN=K()) {
   float l = 0;
-  // Cannot handle graph with dead-ends.
-  if (D) return 0;
-  // Process each level unitl convergence.
+  // Dead ends only scale ranks uniformly, so levels are processed once, with
+  // teleport (1-p)/N, and ranks are normalized at the end.
   for (K n : ns) {
     if (n<=0) { i += -n; continue; }
     T    E1 = EF<=2? E*n/N : E;
-    int  l1 = pagerankMonolithicSeqLoopU<O, D>(a, r, c, f, vfrom, efrom, vdata, i, n, N, p, E1, L, EF);
+    int  l1 = pagerankMonolithicSeqLoopU<O, false>(a, r, c, f, vfrom, efrom, vdata, i, n, N, p, E1, L, EF);
     l += l1 * float(n)/N;
     i += n;
-    if (!O) swap(a, r);
   }
+  if (D) pagerankNormalizeU(r, N);
   return int(l + 0.5f);
 }
 
@@ -60,10 +59,12 @@ PagerankResult<T> pagerankLevelwiseSeq(const G& x, const H& xt, const vector<T>
   const auto& cs = componentsD(x, xt, C);
   const auto& b  = blockgraphD(x, cs, C);
   const auto& bt = blockgraphTransposeD(b, C);
-  auto gs = levelwiseGroupedComponentsFrom(cs, b, bt);
+  auto gs = levelwiseGroupedComponentsD(cs, b, bt, C);
   auto ns = transformIterable(gs, [&](const auto& g) { return g.size(); });
   auto ks = joinValuesVector(gs);
-  return pagerankSeq(xt, ks, 0, ns, pagerankLevelwiseSeqLoopU<O, D, K, T, decltype(ns)>, q, o);
+  reorderSlicesU(ks, ns, x, xt, o.reorder);
+  vector<T> qs; auto qd = pagerankDynamicInitialW<D>(qs, x, x, q, o.damping);
+  return pagerankSeq(xt, ks, 0, ns, pagerankLevelwiseSeqLoopU<O, D, K, T, decltype(ns)>, qd, o);
 }
 template <bool O, bool D, class G, class T=float>
 PagerankResult<T> pagerankLevelwiseSeq(const G& x, const vector<T> *q=nullptr, const PagerankOptions<T>& o={}, const PagerankData<G> *C=nullptr) {
@@ -84,13 +85,15 @@ PagerankResult<T> pagerankLevelwiseSeqDynamic(const G& x, const H& xt, const G&
   const auto& cs = componentsD(x, xt, C);
   const auto& b  = blockgraphD(x, cs, C);
   const auto& bt = blockgraphTransposeD(b, C);
-  auto gi = levelwiseGroupIndices(b, bt);
-  auto [is, n] = dynamicInComponentIndices(x, xt, y, yt, cs, b);  if (n==0) return PagerankResult<T>::initial(yt, q);
+  auto gi = levelwiseGroupIndicesD(b, bt, C);
+  auto [is, n] = dynamicInComponentIndicesD(x, xt, y, yt, cs, b, o, C);  if (n==0) return PagerankResult<T>::initial(yt, q);
   auto ig = groupValuesVector(sliceIterable(is, 0, n), [&](K i) { return gi[i]; });
   auto gs = joinAt2dVector(cs, ig);
   auto ns = transformIterable(gs, [&](const auto& g) { return g.size(); });
   auto ks = joinValuesVector(gs); joinAtU(ks, cs, sliceIterable(is, n));
-  return pagerankSeq(yt, ks, 0, ns, pagerankLevelwiseSeqLoopU<O, D, K, T, decltype(ns)>, q, o);
+  reorderSlicesU(ks, ns, y, yt, o.reorder);
+  vector<T> qs; auto qd = pagerankDynamicInitialW<D>(qs, x, y, q, o.damping, C);
+  return pagerankSeq(yt, ks, 0, ns, pagerankLevelwiseSeqLoopU<O, D, K, T, decltype(ns)>, qd, o);
 }
 template <class G, class T=float>
 PagerankResult<T> pagerankLevelwiseSeqDynamic(const G& x, const G& y, const vector<T> *q=nullptr, const PagerankOptions<T>& o={}, const PagerankData<G> *C=nullptr) {
@@ -7,34 +7,96 @@
 #include "pagerank.hxx"
 #include "pagerankSeq.hxx"
 #include "pagerankOmp.hxx"
-#include "pagerankMonolithicSeq.hxx"
+#include "pagerankMonolithicFrontierOmp.hxx"
 
 using std::vector;
 using std::swap;
 using std::min;
+using std::max;
 
 
 
 
 // PAGERANK-LOOP
 // -------------
+// Each thread iterates over its slice of vertices, without waiting for others.
+// With dead ends, each slice keeps the sum of ranks of its dead ends, which is
+// recomputed with every pass over it (so it does not drift), and the teleport
+// contribution is found from these partial sums (read atomically).
+
+template <class T>
+inline T pagerankDeadEndSumAtomic(const vector<T>& ds) {
+  T a = T();
+  for (size_t k=0; k<ds.size(); ++k) {
+    T d;
+    #pragma omp atomic read
+    d = ds[k];
+    a += d;
+  }
+  return a;
+}
 
-template <bool O, bool D, class K, class T, bool F=false>
-int pagerankMonolithicBarrierfreeOmpLoopU(vector<T>& a, vector<T>& r, vector<T>& c, const vector<T>& f, const vector<K>& vfrom, const vector<K>& efrom, const vector<K>& vdata, K i, K n, K N, T p, T E, int L, int EF, K EI=K(), K EN=K()) {
+template <class T>
+inline void pagerankDeadEndSetAtomicU(T& d, T x) {
+  #pragma omp atomic write
+  d = x;
+}
+
+
+// Partial sums of ranks of dead ends in slices [is[k], is[k+1]), and outside [i, i+n) (last).
+template <class K, class T>
+vector<T> pagerankDeadEndSlicesOmp(const vector<T>& r, const vector<K>& vdata, const vector<K>& is, K i, K n, K N) {
+  K P = K(is.size()) - 1;
+  vector<T> a(P+1);
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (K k=0; k<P; ++k)
+    a[k] = pagerankDeadEndSum(r, vdata, is[k], is[k+1]-is[k]);
+  a[P] = pagerankDeadEndSum(r, vdata, K(0), i) + pagerankDeadEndSum(r, vdata, i+n, N-i-n);
+  return a;
+}
+
+
+template <bool D, class K, class T>
+int pagerankBarrierfreeSliceLoopU(vector<T>& a, vector<T>& r, const vector<T>& f, const vector<K>& vfrom, const vector<K>& efrom, const vector<K>& vdata, K i, K n, K N, T p, T E, int L, int EF, K EI, K EN, vector<T>& ds, int t) {
+  int l = 0;
+  while (l<L) {
+    T c0 = D? pagerankTeleportFrom(pagerankDeadEndSumAtomic(ds), N, p) : (1-p)/N;
+    if (D) pagerankDeadEndSetAtomicU(ds[t], pagerankCalculateOrderedDeadEndsU(a, r, f, vfrom, efrom, vdata, i, n, c0));
+    else   pagerankCalculateOrderedU(a, r, f, vfrom, efrom, i, n, c0);  // update ranks of vertices
+    T el = pagerankError(a, EN? EI:i, EN? EN:n, EF); ++l;              // compare previous and current ranks
+    if (el<E) break;                                                   // check tolerance
+  }
+  return l;
+}
+
+
+template <bool D, class K, class T>
+float pagerankBarrierfreeOmpSlicesU(vector<T>& a, vector<T>& r, const vector<T>& f, const vector<K>& vfrom, const vector<K>& efrom, const vector<K>& vdata, K i, K n, K N, T p, T E, int L, int EF, K EI, K EN) {
   float l = 0;
-  if (!O) return 0;
-  if (F) EI = 0;
-  if (F) EN = N;
-  // Ordered approach
   int TS = min(omp_get_max_threads(), n);
   K   DN = ceilDiv(n, TS);
+  vector<K> is(TS+1);
+  for (int t=0; t<=TS; ++t)
+    is[t] = min(i+t*DN, i+n);
+  vector<T> ds = D? pagerankDeadEndSlicesOmp(r, vdata, is, i, n, N) : vector<T>();
   #pragma omp parallel for schedule(static, 1) reduction(+:l)
   for (int t=0; t<TS; t++) {
-    K    i1 = i+t*DN, I1 = min(i1+DN, i+n), n1 = max(I1-i1, 0);
+    K    i1 = is[t], n1 = is[t+1] - is[t];
     if  (n1==0) continue;
-    int  l1 = pagerankMonolithicSeqLoopU<O, D>(a, r, c, f, vfrom, efrom, vdata, i1, n1, N, p, E, L, EF, EI, EN);
+    int  l1 = pagerankBarrierfreeSliceLoopU<D>(a, r, f, vfrom, efrom, vdata, i1, n1, N, p, E, L, EF, EI, EN, ds, t);
     l += l1 * float(n1)/n;
   }
+  return l;
+}
+
+
+template <bool O, bool D, class K, class T, bool F=false>
+int pagerankMonolithicBarrierfreeOmpLoopU(vector<T>& a, vector<T>& r, vector<T>& c, const vector<T>& f, const vector<K>& vfrom, const vector<K>& efrom, const vector<K>& vdata, K i, K n, K N, T p, T E, int L, int EF, K EI=K(), K EN=K()) {
+  if (!O) return 0;
+  if (F) EI = 0;
+  if (F) EN = N;
+  // Ordered approach
+  float l = pagerankBarrierfreeOmpSlicesU<D>(a, r, f, vfrom, efrom, vdata, i, n, N, p, E, L, EF, EI, EN);
   return int(l + 0.5f);
 }
 
@@ -54,6 +116,7 @@ template <bool O, bool D, bool F, class G, class H, class T=float>
 PagerankResult<T> pagerankMonolithicBarrierfreeOmp(const G& x, const H& xt, const vector<T> *q=nullptr, const PagerankOptions<T>& o={}, const PagerankData<G> *C=nullptr) {
   using K = typename G::key_type;
   K    N  = xt.order();  if (N==0) return PagerankResult<T>::initial(xt, q);
+  auto xc = slackCsrD(xt, o, C);  if (xc) return pagerankOmp(xt, *xc, K(0), N, pagerankMonolithicBarrierfreeOmpLoopU<O, D, K, T, F>, q, o);
   auto ks = pagerankVertices(x, xt, o, C);
   return pagerankOmp(xt, ks, K(0), N, pagerankMonolithicBarrierfreeOmpLoopU<O, D, K, T, F>, q, o);
 }
@@ -70,12 +133,26 @@ PagerankResult<T> pagerankMonolithicBarrierfreeOmp(const G& x, const vector<T> *
 // PAGERANK (DYNAMIC)
 // ------------------
 
+// With frontier option, only vertices with large residual are updated
+// (see pagerankMonolithicFrontierOmpDynamic).
 template <bool O, bool D, bool F, class G, class H, class T=float>
 PagerankResult<T> pagerankMonolithicBarrierfreeOmpDynamic(const G& x, const H& xt, const G& y, const H& yt, const vector<T> *q=nullptr, const PagerankOptions<T>& o={}, const PagerankData<G> *C=nullptr) {
   using K = typename G::key_type;
+  if (o.frontier) return pagerankMonolithicFrontierOmpDynamic<D>(x, xt, y, yt, q, o, C);
   K     N = yt.order();                                        if (N==0) return PagerankResult<T>::initial(yt, q);
   auto [ks, n] = pagerankDynamicVertices(x, xt, y, yt, o, C);  if (n==0) return PagerankResult<T>::initial(yt, q);
-  return pagerankOmp(yt, ks, K(0), n, pagerankMonolithicBarrierfreeOmpLoopU<O, D, K, T, F>, q, o);
+  vector<T> qs; auto qd = pagerankDynamicInitialOmpW<D>(qs, x, y, q, o.damping, C);
+  return pagerankOmp(yt, ks, K(0), n, pagerankNormalizedLoopOmp<D>(pagerankMonolithicBarrierfreeOmpLoopU<O, false, K, T, F>), qd, o);
+}
+
+// Affected vertices (ks[0..n)) may be found beforehand, e.g. for the next
+// batch while ranks of this one are being computed (see pagerankDynamicVertices).
+// With dead ends (D), initial ranks must be scaled to teleport (1-p)/N
+// (see pagerankDynamicInitialOmpW).
+template <bool O, bool D, bool F, class H, class K, class T=float>
+PagerankResult<T> pagerankMonolithicBarrierfreeOmpDynamic(const H& yt, const vector<K>& ks, K n, const vector<T> *q=nullptr, const PagerankOptions<T>& o={}) {
+  K     N = yt.order();  if (N==0 || n==0) return PagerankResult<T>::initial(yt, q);
+  return pagerankOmp(yt, ks, K(0), n, pagerankNormalizedLoopOmp<D>(pagerankMonolithicBarrierfreeOmpLoopU<O, false, K, T, F>), q, o);
 }
 
 template <bool O, bool D, bool F, class G, class T=float>
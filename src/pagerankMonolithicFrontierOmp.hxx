@@ -0,0 +1,361 @@
+#pragma once
+#include <utility>
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <thread>
+#include <omp.h>
+#include "_main.hxx"
+#include "vertices.hxx"
+#include "csr.hxx"
+#include "transpose.hxx"
+#include "dynamic.hxx"
+#include "pagerank.hxx"
+#include "pagerankSeq.hxx"
+#include "pagerankOmp.hxx"
+
+using std::vector;
+using std::swap;
+using std::numeric_limits;
+using std::abs;
+using std::nextafter;
+using std::min;
+using std::this_thread::yield;
+
+
+
+
+// PAGERANK-WORKLIST
+// -----------------
+// Vertices waiting to be updated. Each thread pushes to and pops from its own
+// private stack, and moves older half of it to its shared stack when it grows
+// large. A thread with no work takes half of a shared stack (own, or steal).
+// A vertex is queued at most once at a time (queued flag), and is counted as
+// pending until it has been updated (so that no pending implies convergence).
+
+#define PAGERANK_WORKLIST_SHARE 64  // private stack size at which to share
+
+
+template <class K>
+class PagerankWorklist {
+  // Data.
+  protected:
+  vector<vector<K>>  locals;
+  vector<vector<K>>  stacks;
+  vector<omp_lock_t> locks;
+  vector<char> queued;
+  K pending = 0;
+
+
+  // Property operations.
+  public:
+  inline K size() const noexcept {
+    K a;
+    #pragma omp atomic read
+    a = pending;
+    return a;
+  }
+  inline bool empty() const noexcept { return size()==0; }
+
+
+  // Update operations.
+  protected:
+  inline bool mark(K v) {
+    char old;
+    #pragma omp atomic read
+    old = queued[v];
+    if (old) return false;
+    #pragma omp atomic capture
+    { old = queued[v]; queued[v] = 1; }
+    if (old) return false;
+    #pragma omp atomic update
+    ++pending;
+    return true;
+  }
+
+  public:
+  // Add vertex to private stack of thread (t), if not already queued.
+  inline bool push(int t, K v) {
+    if (!mark(v)) return false;
+    auto& a = locals[t];
+    a.push_back(v);
+    if (a.size() < 2*PAGERANK_WORKLIST_SHARE) return true;
+    size_t m = a.size()/2;
+    omp_set_lock(&locks[t]);
+    stacks[t].insert(stacks[t].end(), a.begin(), a.begin()+m);
+    omp_unset_lock(&locks[t]);
+    a.erase(a.begin(), a.begin()+m);
+    return true;
+  }
+
+  // Take a vertex from private stack of thread (t), or else from shared ones.
+  inline bool pop(int t, K& v) {
+    int  T = int(stacks.size());
+    auto& b = locals[t];
+    for (int s=0; s<T && b.empty(); ++s) {
+      int h = (t+s) % T;
+      omp_set_lock(&locks[h]);
+      auto& a = stacks[h];
+      size_t m = a.size() - a.size()/2;
+      b.insert(b.end(), a.end()-m, a.end());
+      a.resize(a.size()-m);
+      omp_unset_lock(&locks[h]);
+    }
+    if (b.empty()) return false;
+    v = b.back(); b.pop_back();
+    #pragma omp atomic write
+    queued[v] = 0;
+    return true;
+  }
+
+  // Mark a popped vertex as updated.
+  inline void done() {
+    #pragma omp atomic update
+    --pending;
+  }
+
+
+  // Lifetime operations.
+  public:
+  PagerankWorklist(int T, K S) :
+  locals(T), stacks(T), locks(T), queued(S) {
+    for (auto& l : locks)
+      omp_init_lock(&l);
+  }
+
+  ~PagerankWorklist() {
+    for (auto& l : locks)
+      omp_destroy_lock(&l);
+  }
+
+  PagerankWorklist(const PagerankWorklist&) = delete;
+  PagerankWorklist& operator=(const PagerankWorklist&) = delete;
+};
+
+
+
+
+// PAGERANK-LOOP
+// -------------
+// Only vertices with a large enough residual are updated (delta-push).
+// Residual (e) of a vertex is how much its rank is yet to change. It starts as
+// the difference of rank from what in-neighbours give (for seed vertices), and
+// an update adds it to rank, and pushes it (times factor) to residual of
+// out-neighbours (push CSR: ofrom, eto). A vertex is queued once its residual
+// reaches tolerance (E), so all residuals are below E when the worklist runs
+// empty, i.e., one more sweep would change no rank by E or more (as with the
+// L∞-norm check). Threads update vertices from the worklist without any barrier.
+// Once the worklist runs empty, residuals of vertices touched are recomputed
+// (as pushes add up rounding errors), and the vertices still above tolerance
+// are processed again. Teleport is fixed at (1-p)/N; with dead ends (D), ranks
+// only differ by a uniform scale, and are normalized at the end (see
+// pagerankSeq.hxx). Updates are limited to L*N over all threads; if this limit
+// is reached, ranks are normalized, and L is returned as no. of iterations.
+
+#define PAGERANK_FRONTIER_WORK 256  // updates after which a thread adds to shared count
+
+
+template <bool D, class K, class T>
+int pagerankMonolithicFrontierOmpLoopU(vector<T>& r, vector<T>& e, const vector<T>& f, const vector<K>& vfrom, const vector<K>& efrom, const vector<K>& ofrom, const vector<K>& eto, const vector<K>& seeds, K N, T p, T E, int L, PagerankThreadWork *W=nullptr) {
+  int  TS = omp_get_max_threads();
+  PagerankWorklist<K> q(TS, N);
+  vector<int64_t> tw(TS);  // vertices updated by each thread
+  vector<float>   ti(TS);  // time spent by each thread waiting for work (ms)
+  vector<char>    vt(N);   // vertex touched, since last residual calculation?
+  int64_t work = 0, WL = int64_t(L) * N;  // vertices updated by all threads, limit
+  T    c0 = (1-p)/N;
+  bool stop = false, converged = false;
+  auto residual = [&](K v) {
+    T a = c0;
+    for (K u : sliceIterable(efrom, vfrom[v], vfrom[v+1]))
+      a += f[u] * r[u];
+    return a - r[v];
+  };
+  // Rank cannot change by less than its precision (ulp), so such residuals are
+  // rounding errors, and would be moved back and forth.
+  auto ulp = [](T x) { return nextafter(abs(x), numeric_limits<T>::infinity()) - abs(x); };
+  auto touch = [&](K v) {
+    #pragma omp atomic write
+    vt[v] = 1;
+  };
+  fillValueOmpU(e, T());
+  for (K v : seeds)
+    vt[v] = 1;
+  for (int m=0; m<L && !stop; ++m) {
+    // Find residuals of touched vertices, and queue the ones above tolerance.
+    // Residuals of untouched vertices are below tolerance (worklist ran empty).
+    #pragma omp parallel
+    {
+      int t = omp_get_thread_num();
+      #pragma omp for schedule(dynamic, 2048)
+      for (K v=0; v<N; ++v) {
+        if (!vt[v]) continue;
+        e[v] = residual(v); vt[v] = 0;
+        if (abs(e[v]) >= E && abs(e[v]) > ulp(r[v])) q.push(t, v);
+      }
+    }
+    if (q.empty()) { converged = true; break; }
+    #pragma omp parallel
+    {
+      int t = omp_get_thread_num();
+      auto stopped = [&]() {
+        bool a;
+        #pragma omp atomic read
+        a = stop;
+        return a;
+      };
+      while (!stopped()) {
+        K v; bool ok = q.pop(t, v);
+        if (!ok) {
+          // Wait for work, until all queued vertices are updated.
+          auto t0 = timeNow();
+          while (!(ok = q.pop(t, v)) && !q.empty() && !stopped())
+            yield();
+          ti[t] += durationMilliseconds(t0, timeNow());
+          if (!ok) break;
+        }
+        // Move residual of vertex (v) to its rank.
+        T dv;
+        #pragma omp atomic capture
+        { dv = e[v]; e[v] = T(); }
+        #pragma omp atomic update
+        r[v] += dv;
+        touch(v);
+        // Push it to out-neighbours, and queue the ones reaching tolerance.
+        T fv = f[v] * dv;
+        if (fv != 0) {
+          for (K w : sliceIterable(eto, ofrom[v], ofrom[v+1])) {
+            T ew; touch(w);
+            #pragma omp atomic capture
+            { ew = e[w]; e[w] += fv; }
+            if (abs(ew) < E && abs(ew+fv) >= E) q.push(t, w);
+          }
+        }
+        q.done();
+        // Stop once all threads together have done L sweeps worth of updates.
+        if (++tw[t] % PAGERANK_FRONTIER_WORK == 0) {
+          int64_t wa;
+          #pragma omp atomic capture
+          wa = work += PAGERANK_FRONTIER_WORK;
+          if (wa >= WL) {
+            #pragma omp atomic write
+            stop = true;
+          }
+        }
+      }
+    }
+  }
+  if (D || !converged) pagerankNormalizeOmpU(r, N);
+  double l = 0;
+  for (int t=0; t<TS; ++t)
+    l += tw[t];
+  if (W) {
+    W->iterations.resize(TS);
+    W->idleTime.resize(TS);
+    for (int t=0; t<TS; ++t) {
+      W->iterations[t] = float(double(tw[t]) * TS / N);
+      W->idleTime[t]   = ti[t];
+    }
+  }
+  return converged? int(l/N + 0.5) : L;
+}
+
+
+
+
+// PAGERANK (STATIC / INCREMENTAL)
+// -------------------------------
+
+// With dead ends (D), initial ranks must be scaled to teleport (1-p)/N
+// (see pagerankDynamicInitialOmpW).
+template <bool D, class G, class H, class J, class T=float>
+PagerankResult<T> pagerankMonolithicFrontierOmpFrom(const G& x, const H& xt, const J& ss, const vector<T> *q=nullptr, const PagerankOptions<T>& o={}) {
+  using K = typename G::key_type;
+  K    N  = xt.order();
+  T    p  = o.damping;
+  T    E  = o.tolerance;
+  int  L  = o.maxIterations, l = 0;
+  auto ks = vertexKeys(xt);
+  reorderSlicesU(ks, vector<size_t> {ks.size()}, x, xt, o.reorder);
+  auto vfrom = sourceOffsetsAsOmp(xt, ks, K());
+  auto efrom = destinationIndicesAsOmp(xt, ks, vfrom);
+  auto ofrom = sourceOffsetsAsOmp(x, ks, K());
+  auto eto   = destinationIndicesAsOmp(x, ks, ofrom);
+  auto vdata = vertexDataOmp(xt, ks);
+  vector<K> ids(xt.span()), seeds;
+  for (K i=0; i<N; ++i)
+    ids[ks[i]] = i;
+  for (auto u : ss)
+    seeds.push_back(ids[u]);
+  auto r = createVectorOmp<T>(N);
+  auto e = createVectorOmp<T>(N);
+  auto f = createVectorOmp<T>(N);
+  vector<T> qc;
+  if (q) qc = compressContainer(xt, *q, ks);
+  PagerankThreadWork w;
+  float t = measureDuration([&]() {
+    if (q) copyValuesOmpW(r, qc);  // copy old ranks (qc), if given
+    else fillValueOmpU(r, T(1)/N);
+    pagerankFactorOmpW(f, vdata, 0, N, p);
+    l = pagerankMonolithicFrontierOmpLoopU<D>(r, e, f, vfrom, efrom, ofrom, eto, seeds, N, p, E, L, &w);
+  }, o.repeat);
+  PagerankResult<T> a(decompressContainer(xt, r, ks), l, t);
+  a.threads = move(w);
+  return a;
+}
+
+
+// Find pagerank using multiple threads, updating only vertices with large residual (pull, CSR).
+// @param x  original graph
+// @param xt transpose graph (with vertex-data=out-degree)
+// @param q  initial ranks (optional)
+// @param o  options {damping=0.85, tolerance=1e-6, maxIterations=500}
+// @returns {ranks, iterations, time, threads}
+template <bool D, class G, class H, class T=float>
+PagerankResult<T> pagerankMonolithicFrontierOmp(const G& x, const H& xt, const vector<T> *q=nullptr, const PagerankOptions<T>& o={}, const PagerankData<G> *C=nullptr) {
+  if (xt.order()==0) return PagerankResult<T>::initial(xt, q);
+  vector<T> qs; auto qd = pagerankDynamicInitialOmpW<D>(qs, x, x, q, o.damping);
+  return pagerankMonolithicFrontierOmpFrom<D>(x, xt, vertexKeys(xt), qd, o);
+}
+
+template <bool D, class G, class T=float>
+PagerankResult<T> pagerankMonolithicFrontierOmp(const G& x, const vector<T> *q=nullptr, const PagerankOptions<T>& o={}, const PagerankData<G> *C=nullptr) {
+  auto xt = transposeWithDegree(x);
+  return pagerankMonolithicFrontierOmp<D>(x, xt, q, o, C);
+}
+
+
+
+
+// PAGERANK (DYNAMIC)
+// ------------------
+// Worklist starts with vertices touched by the batch and their out-neighbours
+// (if known), or else all affected vertices.
+
+template <bool D, class G, class H, class T=float>
+PagerankResult<T> pagerankMonolithicFrontierOmpDynamic(const G& x, const H& xt, const G& y, const H& yt, const vector<T> *q=nullptr, const PagerankOptions<T>& o={}, const PagerankData<G> *C=nullptr) {
+  using K = typename G::key_type;
+  if (yt.order()==0) return PagerankResult<T>::initial(yt, q);
+  vector<T> qs; auto qd = pagerankDynamicInitialOmpW<D>(qs, x, y, q, o.damping, C);
+  if (!C || !C->changed) {
+    auto [ks, n] = pagerankDynamicVertices(x, xt, y, yt, o, C);  if (n==0) return PagerankResult<T>::initial(yt, q);
+    return pagerankMonolithicFrontierOmpFrom<D>(y, yt, sliceIterable(ks, 0, n), qd, o);
+  }
+  auto vis = createContainer(y, char());
+  vector<K> ss;
+  auto fs  = [&](K u) { if (y.hasVertex(u) && !vis[u]) { vis[u] = 1; ss.push_back(u); } };
+  for (K u : *C->changed) {
+    fs(u);
+    if (y.hasVertex(u)) y.forEachEdgeKey(u, fs);
+  }
+  if (ss.empty()) return PagerankResult<T>::initial(yt, q);
+  return pagerankMonolithicFrontierOmpFrom<D>(y, yt, ss, qd, o);
+}
+
+template <bool D, class G, class T=float>
+PagerankResult<T> pagerankMonolithicFrontierOmpDynamic(const G& x, const G& y, const vector<T> *q=nullptr, const PagerankOptions<T>& o={}, const PagerankData<G> *C=nullptr) {
+  auto xt = transposeWithDegree(x);
+  auto yt = transposeWithDegree(y);
+  return pagerankMonolithicFrontierOmpDynamic<D>(x, xt, y, yt, q, o, C);
+}
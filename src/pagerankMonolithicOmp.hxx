@@ -31,6 +31,8 @@ int pagerankMonolithicOmpLoopU(vector<T>& a, vector<T>& r, vector<T>& c, const v
     swap(a, r); ++l;                                        // final ranks in (r)
     if (el<E) break;                                        // check tolerance
   }
+  // Only ranks in [i, i+n) are updated, so end with the initial (r)
+  if (!O && l%2) { copyValuesOmpW(a, r, i, n); swap(a, r); }
   // Ordered approach
   while (O && l<L) {
     T c0 = D? pagerankTeleportOmp(r, vdata, N, p) : (1-p)/N;
@@ -57,6 +59,7 @@ template <bool O, bool D, class G, class H, class T=float>
 PagerankResult<T> pagerankMonolithicOmp(const G& x, const H& xt, const vector<T> *q=nullptr, const PagerankOptions<T>& o={}, const PagerankData<G> *C=nullptr) {
   using K = typename G::key_type;
   K    N  = xt.order();  if (N==0) return PagerankResult<T>::initial(xt, q);
+  auto xc = slackCsrD(xt, o, C);  if (xc) return pagerankOmp(xt, *xc, K(0), N, pagerankMonolithicOmpLoopU<O, D, K, T>, q, o);
   auto ks = pagerankVertices(x, xt, o, C);
   return pagerankOmp(xt, ks, K(0), N, pagerankMonolithicOmpLoopU<O, D, K, T>, q, o);
 }
@@ -78,7 +81,8 @@ PagerankResult<T> pagerankMonolithicOmpDynamic(const G& x, const H& xt, const G&
   using K = typename G::key_type;
   K     N = yt.order();                                        if (N==0) return PagerankResult<T>::initial(yt, q);
   auto [ks, n] = pagerankDynamicVertices(x, xt, y, yt, o, C);  if (n==0) return PagerankResult<T>::initial(yt, q);
-  return pagerankOmp(yt, ks, K(0), n, pagerankMonolithicOmpLoopU<O, D, K, T>, q, o);
+  vector<T> qs; auto qd = pagerankDynamicInitialOmpW<D>(qs, x, y, q, o.damping, C);
+  return pagerankOmp(yt, ks, K(0), n, pagerankNormalizedLoopOmp<D>(pagerankMonolithicOmpLoopU<O, false, K, T>), qd, o);
 }
 
 template <bool O, bool D, class G, class T=float>
@@ -0,0 +1,168 @@
+#pragma once
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <type_traits>
+#include "_main.hxx"
+#include "transpose.hxx"
+#include "dynamic.hxx"
+#include "pagerank.hxx"
+#include "pagerankSeq.hxx"
+#include "pagerankOmp.hxx"
+
+using std::vector;
+using std::abs;
+using std::sqrt;
+using std::min;
+using std::max;
+using std::is_same;
+
+
+
+
+// PAGERANK-LOOP
+// -------------
+// Contributions of vertices are kept in storage type S (float, Bfloat16,
+// Float16), scaled up by N to stay clear of 16-bit underflow, and gathered
+// with SIMD. Vertices with few in-edges are processed SIMD_LANES at a time
+// (one vertex per lane), and the rest have their in-edge sum vectorized.
+// In-edge sums are accumulated in double, and each update only stores the
+// rank and its contribution. Change in stored ranks is reduced as it is
+// found (as per EF), instead of with another pass, and so is change in the
+// sum of ranks of dead ends (D) that sets the teleport contribution.
+
+#ifndef PAGERANK_SIMD_DEGREE
+#define PAGERANK_SIMD_DEGREE SIMD_LANES
+#endif
+
+template <class S, class K>
+inline double pagerankStorageScale(K N) {
+  // Contributions of Float16 must remain below its maximum (65504).
+  return is_same<S, Float16>::value? double(min(N, K(1) << 14)) : double(N);
+}
+
+// Contributions rounded to 16 bits (8 or 11 significant bits) bias ranks by
+// about this much (L1-norm), so a smaller tolerance does not make them closer.
+template <class S>
+inline constexpr double pagerankStorageTolerance() {
+  return is_same<S, float>::value? 0.0 : 1e-3;
+}
+
+
+// Contributions (cs) must have space for one more value (padded for 16-bit gathers).
+template <bool D, class S, class K, class T>
+int pagerankMonolithicSimdOmpLoopU(vector<T>& r, vector<S>& cs, const vector<T>& f, const vector<K>& vfrom, const vector<K>& efrom, const vector<K>& vdata, K i, K n, K N, T p, T E, int L, int EF) {
+  if (n<=0) return 0;
+  const K W  = K(SIMD_LANES);
+  const K DL = K(PAGERANK_SIMD_DEGREE);
+  K    Z  = K(r.size());
+  double sc = pagerankStorageScale<S>(N);
+  #pragma omp parallel for schedule(auto)
+  for (K u=0; u<Z; ++u)
+    cs[u] = S(float(sc * f[u] * r[u]));
+  double ds = 0;  // sum of ranks of dead ends
+  if (D) {
+    #pragma omp parallel for schedule(auto) reduction(+:ds)
+    for (K u=0; u<N; ++u)
+      if (vdata[u]==0) ds += r[u];
+  }
+  int l = 0;
+  while (l<L) {
+    double c0 = D? pagerankTeleportFrom(ds, N, double(p)) : (1-p)/N;
+    double es = 0, em = 0, dd = 0;  // sum, max of change in ranks, change in dead end sum
+    #pragma omp parallel reduction(+:es, dd) reduction(max:em)
+    {
+      double s[SIMD_LANES];
+      K      vs[SIMD_LANES], w = 0;
+      auto   fu = [&](K v, double sv) {
+        T rv = T(c0 + sv/sc);
+        T ev = abs(rv - r[v]);
+        if (D && vdata[v]==0) dd += double(rv) - r[v];
+        r[v]  = rv;
+        cs[v] = S(float(sc * f[v] * rv));
+        if (EF==1) es += ev;
+        else if (EF==2) es += double(ev) * ev;
+        else em = max(em, double(ev));
+      };
+      auto   fw = [&]() {
+        sumValuesAtLanesW(s, cs.data(), vfrom.data(), efrom.data(), vs, size_t(w));
+        for (K k=0; k<w; ++k)
+          fu(vs[k], s[k]);
+        w = 0;
+      };
+      #pragma omp for schedule(dynamic, 2048) nowait
+      for (K v=i; v<i+n; ++v) {
+        K d = vfrom[v+1] - vfrom[v];
+        if (d>=DL) fu(v, sumValuesAtSimd(cs.data(), efrom.data()+vfrom[v], size_t(d)));
+        else { vs[w++] = v; if (w==W) fw(); }
+      }
+      if (w>0) fw();
+    }
+    ds += dd;
+    T el = T(EF==1? es : (EF==2? sqrt(es) : em)); ++l;  // compare previous and current ranks
+    if (el<E) break;                                   // check tolerance
+  }
+  return l;
+}
+
+
+// Loop upon contributions (cs) allocated by caller, outside of timed region.
+template <bool D, class S, class K, class T>
+inline auto pagerankMonolithicSimdOmpLoop(vector<S>& cs) {
+  return [&cs](vector<T>&, vector<T>& r, vector<T>&, const vector<T>& f, const vector<K>& vfrom, const vector<K>& efrom, const vector<K>& vdata, K i, K n, K N, T p, T E, int L, int EF, K, K) {
+    return pagerankMonolithicSimdOmpLoopU<D>(r, cs, f, vfrom, efrom, vdata, i, n, N, p, E, L, EF);
+  };
+}
+
+
+
+
+// PAGERANK (STATIC / INCREMENTAL)
+// -------------------------------
+
+// Find pagerank using multiple threads, with SIMD gathers (pull, CSR).
+// @param x  original graph
+// @param xt transpose graph (with vertex-data=out-degree)
+// @param q  initial ranks (optional)
+// @param o  options {damping=0.85, tolerance=1e-6, maxIterations=500}
+// @returns {ranks, iterations, time}
+template <bool D, class S=float, class G, class H, class T=float>
+PagerankResult<T> pagerankMonolithicSimdOmp(const G& x, const H& xt, const vector<T> *q=nullptr, const PagerankOptions<T>& o={}, const PagerankData<G> *C=nullptr) {
+  using K = typename G::key_type;
+  K    N  = xt.order();  if (N==0) return PagerankResult<T>::initial(xt, q);
+  auto xc = slackCsrD(xt, o, C);
+  vector<S> cs((xc? xc->span() : N) + 1);
+  auto fl = pagerankMonolithicSimdOmpLoop<D, S, K, T>(cs);
+  if (xc) return pagerankOmp(xt, *xc, K(0), N, fl, q, o);
+  auto ks = pagerankVertices(x, xt, o, C);
+  return pagerankOmp(xt, ks, K(0), N, fl, q, o);
+}
+
+template <bool D, class S=float, class G, class T=float>
+PagerankResult<T> pagerankMonolithicSimdOmp(const G& x, const vector<T> *q=nullptr, const PagerankOptions<T>& o={}, const PagerankData<G> *C=nullptr) {
+  auto xt = transposeWithDegree(x);
+  return pagerankMonolithicSimdOmp<D, S>(x, xt, q, o, C);
+}
+
+
+
+
+// PAGERANK (DYNAMIC)
+// ------------------
+
+template <bool D, class S=float, class G, class H, class T=float>
+PagerankResult<T> pagerankMonolithicSimdOmpDynamic(const G& x, const H& xt, const G& y, const H& yt, const vector<T> *q=nullptr, const PagerankOptions<T>& o={}, const PagerankData<G> *C=nullptr) {
+  using K = typename G::key_type;
+  K     N = yt.order();                                        if (N==0) return PagerankResult<T>::initial(yt, q);
+  auto [ks, n] = pagerankDynamicVertices(x, xt, y, yt, o, C);  if (n==0) return PagerankResult<T>::initial(yt, q);
+  vector<T> qs; auto qd = pagerankDynamicInitialOmpW<D>(qs, x, y, q, o.damping, C);
+  vector<S> cs(N+1);
+  return pagerankOmp(yt, ks, K(0), n, pagerankNormalizedLoopOmp<D>(pagerankMonolithicSimdOmpLoop<false, S, K, T>(cs)), qd, o);
+}
+
+template <bool D, class S=float, class G, class T=float>
+PagerankResult<T> pagerankMonolithicSimdOmpDynamic(const G& x, const G& y, const vector<T> *q=nullptr, const PagerankOptions<T>& o={}, const PagerankData<G> *C=nullptr) {
+  auto xt = transposeWithDegree(x);
+  auto yt = transposeWithDegree(y);
+  return pagerankMonolithicSimdOmpDynamic<D, S>(x, xt, y, yt, q, o, C);
+}
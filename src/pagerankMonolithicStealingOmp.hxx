@@ -0,0 +1,279 @@
+#pragma once
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include "_main.hxx"
+#include "transpose.hxx"
+#include "dynamic.hxx"
+#include "pagerank.hxx"
+#include "pagerankSeq.hxx"
+#include "pagerankOmp.hxx"
+#include "pagerankMonolithicBarrierfreeOmp.hxx"
+
+using std::vector;
+using std::numeric_limits;
+using std::sqrt;
+using std::min;
+using std::max;
+
+
+
+
+// PAGERANK-CHUNKS
+// ---------------
+// Split vertices into chunks of about the same work (in-edges + vertices).
+
+template <class K>
+vector<K> pagerankBalancedChunks(const vector<K>& vfrom, K i, K n, K P) {
+  size_t W = size_t(vfrom[i+n] - vfrom[i]) + size_t(n);
+  auto   w = [&](K v) { return size_t(vfrom[v] - vfrom[i]) + size_t(v-i); };
+  vector<K> a(P+1);
+  a[0] = i; a[P] = i+n;
+  for (K k=1; k<P; ++k) {
+    size_t wk = W * k / P;
+    K lo = a[k-1], hi = i+n;
+    while (lo<hi) {
+      K m = lo + (hi-lo)/2;
+      if (w(m) < wk) lo = m+1;
+      else hi = m;
+    }
+    a[k] = lo;
+  }
+  return a;
+}
+
+
+
+
+// PAGERANK-LOOP
+// -------------
+// Each thread owns a contiguous range of chunks, and sweeps it without
+// waiting for other threads. A thread that gets more than one sweep ahead of
+// the slowest range takes (steals) the next chunk of that range instead.
+// Every chunk publishes the error of its last pass, and after each pass a
+// thread combines these (lock-free) into the error over all vertices, which
+// is compared with tolerance as in the other engines.
+// A pass whose error reaches the chunk's share of tolerance bumps a shared
+// generation, which makes errors of all chunks passed before it stale. A chunk
+// is passed over again only if its error is stale or above its share, and the
+// loop stops once no error is stale and combined error is within tolerance
+// (or no chunk above its share has passes left).
+// Sum of ranks of dead ends is kept per chunk, and set after each pass over it.
+
+template <class K>
+inline bool pagerankClaimChunkU(vector<char>& busy, K k) {
+  char old;
+  #pragma omp atomic capture seq_cst
+  { old = busy[k]; busy[k] = 1; }
+  return !old;
+}
+
+template <class K>
+inline void pagerankReleaseChunkU(vector<char>& busy, K k) {
+  #pragma omp atomic write seq_cst
+  busy[k] = 0;
+}
+
+
+// Combine last errors of chunks (read atomically), as per error function (EF).
+template <class T>
+inline T pagerankChunkErrorAtomic(const vector<T>& es, int EF) {
+  T a = T();
+  for (size_t k=0; k<es.size(); ++k) {
+    T e;
+    #pragma omp atomic read
+    e = es[k];
+    switch (EF) {
+      case 1:  a += e;   break;
+      case 2:  a += e*e; break;
+      default: a  = max(a, e);
+    }
+  }
+  return EF==2? sqrt(a) : a;
+}
+
+
+// Check if last passes over all chunks began in generation (g).
+inline bool pagerankChunksFreshAtomic(const vector<int64_t>& gs, int64_t g) {
+  for (size_t k=0; k<gs.size(); ++k) {
+    int64_t h;
+    #pragma omp atomic read
+    h = gs[k];
+    if (h!=g) return false;
+  }
+  return true;
+}
+
+
+template <bool D, class K, class T>
+int pagerankMonolithicStealingOmpLoopU(vector<T>& a, vector<T>& r, vector<T>& c, const vector<T>& f, const vector<K>& vfrom, const vector<K>& efrom, const vector<K>& vdata, K i, K n, K N, T p, T E, int L, int EF, PagerankThreadWork *W=nullptr) {
+  if (n<=0) return 0;
+  int  TS = min(omp_get_max_threads(), int(n));
+  K    CH = max(min(K(8), n/(K(TS)*256)), K(1));  // chunks per thread
+  K    P  = K(TS)*CH;
+  auto cs = pagerankBalancedChunks(vfrom, i, n, P);
+  vector<T>    ce(P, numeric_limits<T>::infinity());  // error of last pass over each chunk
+  vector<T>    cE(P);         // share of tolerance of each chunk
+  vector<int64_t> cg(P, -1);  // generation at start of last pass over each chunk
+  vector<int>  cl(P);         // passes over each chunk
+  vector<char> cb(P);         // chunk busy?
+  vector<int64_t> cur(TS);    // claims on each range of chunks
+  vector<double>  tw(TS);     // vertices updated by each thread
+  vector<float>   tb(TS);     // time each thread spent updating ranks (ms)
+  vector<float>   tt(TS);     // time each thread stopped (ms)
+  char done   = 0;            // converged, or no passes left?
+  int64_t gen = 0;            // passes with error above share of tolerance
+  for (K k=0; k<P; ++k) {
+    T nk = T(cs[k+1] - cs[k]) / n;
+    cE[k] = EF==1? E*nk : (EF==2? E*sqrt(nk) : E);
+  }
+  // No chunk has error above its share, with passes left?
+  auto idle = [&]() {
+    for (K k=0; k<P; ++k) {
+      T e; int l;
+      #pragma omp atomic read
+      e = ce[k];
+      #pragma omp atomic read
+      l = cl[k];
+      if (e>=cE[k] && l<L) return false;
+    }
+    return true;
+  };
+  vector<T> ds = D? pagerankDeadEndSlicesOmp(r, vdata, cs, i, n, N) : vector<T>();
+  auto t0 = timeNow();
+  #pragma omp parallel num_threads(TS)
+  {
+    int t = omp_get_thread_num();
+    while (true) {
+      char dn;
+      #pragma omp atomic read
+      dn = done;
+      if (dn) break;
+      // Pick own range, unless it is ahead of the slowest one.
+      int h = t; int64_t sh, sm;
+      #pragma omp atomic read
+      sh = cur[t];
+      sh /= CH; sm = sh;
+      for (int s=0; s<TS; ++s) {
+        int64_t ss;
+        #pragma omp atomic read
+        ss = cur[s];
+        ss /= CH;
+        if (ss+1 < sm) { h = s; sm = ss; }
+      }
+      int64_t j;
+      #pragma omp atomic capture
+      j = cur[h]++;
+      K k = K(h)*CH + K(j % CH);
+      if (!pagerankClaimChunkU(cb, k)) continue;
+      K i1 = cs[k], n1 = cs[k+1] - cs[k];
+      int64_t g;
+      #pragma omp atomic read
+      g = gen;
+      if (cl[k] >= L) {  // error of capped chunk can no longer change
+        #pragma omp atomic write
+        cg[k] = g;
+      }
+      else if (cg[k]!=g || ce[k]>=cE[k]) {
+        auto t1 = timeNow();
+        T c0 = D? pagerankTeleportFrom(pagerankDeadEndSumAtomic(ds), N, p) : (1-p)/N;
+        if (D) pagerankDeadEndSetAtomicU(ds[k], pagerankCalculateOrderedDeadEndsU(a, r, f, vfrom, efrom, vdata, i1, n1, c0));
+        else   pagerankCalculateOrderedU(a, r, f, vfrom, efrom, i1, n1, c0);  // update ranks of vertices
+        T el = pagerankError(a, i1, n1, EF);                                // error of this chunk
+        #pragma omp atomic write
+        ce[k] = el;
+        #pragma omp atomic write
+        cg[k] = g;
+        if (el >= cE[k]) {
+          #pragma omp atomic update
+          ++gen;
+        }
+        #pragma omp atomic update
+        ++cl[k];
+        tw[t] += n1; tb[t] += durationMilliseconds(t1, timeNow());
+      }
+      pagerankReleaseChunkU(cb, k);
+      #pragma omp atomic read
+      g = gen;
+      if (!pagerankChunksFreshAtomic(cg, g)) continue;
+      if (pagerankChunkErrorAtomic(ce, EF) >= E && !idle()) continue;  // check tolerance
+      #pragma omp atomic write
+      done = 1;
+    }
+    tt[t] = durationMilliseconds(t0, timeNow());
+  }
+  double l = 0;
+  for (int t=0; t<TS; ++t)
+    l += tw[t];
+  if (W) {
+    float tm = *max_element(tt.begin(), tt.end());
+    W->iterations.resize(TS);
+    W->idleTime.resize(TS);
+    for (int t=0; t<TS; ++t) {
+      W->iterations[t] = float(tw[t] * TS / n);
+      W->idleTime[t]   = tm - tb[t];  // looking for chunks, and waiting at the end
+    }
+  }
+  return int(l/n + 0.5);
+}
+
+
+
+
+// PAGERANK (STATIC / INCREMENTAL)
+// -------------------------------
+
+// Find pagerank using multiple threads, with work-stealing (pull, CSR).
+// @param x  original graph
+// @param xt transpose graph (with vertex-data=out-degree)
+// @param q  initial ranks (optional)
+// @param o  options {damping=0.85, tolerance=1e-6, maxIterations=500}
+// @returns {ranks, iterations, time, threads}
+template <bool D, class G, class H, class T=float>
+PagerankResult<T> pagerankMonolithicStealingOmp(const G& x, const H& xt, const vector<T> *q=nullptr, const PagerankOptions<T>& o={}, const PagerankData<G> *C=nullptr) {
+  using K = typename G::key_type;
+  K    N  = xt.order();  if (N==0) return PagerankResult<T>::initial(xt, q);
+  PagerankThreadWork w;
+  auto fl = [&](auto& a, auto& r, auto& c, const auto& f, const auto& vfrom, const auto& efrom, const auto& vdata, K i, K n, K N, T p, T E, int L, int EF, K EI, K EN) {
+    return pagerankMonolithicStealingOmpLoopU<D>(a, r, c, f, vfrom, efrom, vdata, i, n, N, p, E, L, EF, &w);
+  };
+  auto xc = slackCsrD(xt, o, C);
+  auto a  = xc? pagerankOmp(xt, *xc, K(0), N, fl, q, o) : pagerankOmp(xt, pagerankVertices(x, xt, o, C), K(0), N, fl, q, o);
+  a.threads = move(w);
+  return a;
+}
+
+template <bool D, class G, class T=float>
+PagerankResult<T> pagerankMonolithicStealingOmp(const G& x, const vector<T> *q=nullptr, const PagerankOptions<T>& o={}, const PagerankData<G> *C=nullptr) {
+  auto xt = transposeWithDegree(x);
+  return pagerankMonolithicStealingOmp<D>(x, xt, q, o, C);
+}
+
+
+
+
+// PAGERANK (DYNAMIC)
+// ------------------
+
+template <bool D, class G, class H, class T=float>
+PagerankResult<T> pagerankMonolithicStealingOmpDynamic(const G& x, const H& xt, const G& y, const H& yt, const vector<T> *q=nullptr, const PagerankOptions<T>& o={}, const PagerankData<G> *C=nullptr) {
+  using K = typename G::key_type;
+  K     N = yt.order();                                        if (N==0) return PagerankResult<T>::initial(yt, q);
+  auto [ks, n] = pagerankDynamicVertices(x, xt, y, yt, o, C);  if (n==0) return PagerankResult<T>::initial(yt, q);
+  vector<T> qs; auto qd = pagerankDynamicInitialOmpW<D>(qs, x, y, q, o.damping, C);
+  PagerankThreadWork w;
+  auto fl = [&](auto& a, auto& r, auto& c, const auto& f, const auto& vfrom, const auto& efrom, const auto& vdata, K i, K n, K N, T p, T E, int L, int EF, K EI, K EN) {
+    return pagerankMonolithicStealingOmpLoopU<false>(a, r, c, f, vfrom, efrom, vdata, i, n, N, p, E, L, EF, &w);
+  };
+  auto a = pagerankOmp(yt, ks, K(0), n, pagerankNormalizedLoopOmp<D>(fl), qd, o);
+  a.threads = move(w);
+  return a;
+}
+
+template <bool D, class G, class T=float>
+PagerankResult<T> pagerankMonolithicStealingOmpDynamic(const G& x, const G& y, const vector<T> *q=nullptr, const PagerankOptions<T>& o={}, const PagerankData<G> *C=nullptr) {
+  auto xt = transposeWithDegree(x);
+  auto yt = transposeWithDegree(y);
+  return pagerankMonolithicStealingOmpDynamic<D>(x, xt, y, yt, q, o, C);
+}
@@ -48,6 +48,64 @@ T pagerankTeleportOmp(const vector<T>& r, const vector<K>& vdata, K N, T p) {
 
 
 
+// PAGERANK-DEAD-ENDS
+// ------------------
+// Ranks found with teleport (1-p)/N are normalized (see pagerankSeq.hxx).
+
+template <class K, class T>
+inline void pagerankNormalizeOmpU(vector<T>& r, K N) {
+  T s = sumValuesOmp(r, 0, N);
+  if (s>0) multiplyValueOmp(r, r, 0, N, 1/s);
+}
+
+
+template <class G, class T>
+T pagerankTeleportOfOmp(const G& x, const vector<T>& q, T p) {
+  using K = typename G::key_type;
+  K S = x.span();  if (S<SIZE_MIN_OMPR) return pagerankTeleportOf(x, q, p);
+  T a = T();
+  #pragma omp parallel for schedule(static, 2048) reduction(+:a)
+  for (K u=0; u<S; ++u)
+    if (x.hasVertex(u)) a += (isDeadEnd(x, u)? 1 : 1-p) * q[u];
+  return a / x.order();
+}
+
+template <class K, class T>
+T pagerankTeleportOfOmp(const vector<K>& ks, const vector<K>& ds, const vector<T>& q, T p) {
+  size_t S = ks.size();  if (S<SIZE_MIN_OMPR) return pagerankTeleportOf(ks, ds, q, p);
+  T a = T();
+  #pragma omp parallel for schedule(static, 2048) reduction(+:a)
+  for (size_t i=0; i<S; ++i)
+    a += (1-p) * q[ks[i]];
+  #pragma omp parallel for schedule(static, 2048) reduction(+:a)
+  for (size_t i=0; i<ds.size(); ++i)
+    a += p * q[ds[i]];
+  return a / S;
+}
+
+template <bool D, class G, class T>
+const vector<T>* pagerankDynamicInitialOmpW(vector<T>& a, const G& x, const G& y, const vector<T> *q, T p, const PagerankData<G> *C=nullptr) {
+  bool old = C && C->verticesOld;
+  if (!D || !q || (old? C->verticesOld->empty() : x.order()==0)) return q;
+  T c = old? pagerankTeleportOfOmp(*C->verticesOld, *C->deadEndsOld, *q, p) : pagerankTeleportOfOmp(x, *q, p);  if (c<=0) return q;
+  a.resize(q->size());
+  multiplyValueOmp(*q, a, (1-p)/(y.order()*c));
+  return &a;
+}
+
+
+template <bool D, class FL>
+inline auto pagerankNormalizedLoopOmp(FL fl) {
+  return [fl](auto& a, auto& r, auto& c, const auto& f, const auto& vfrom, const auto& efrom, const auto& vdata, auto i, const auto& ns, auto N, auto p, auto E, int L, int EF, auto EI, auto EN) {
+    int l = fl(a, r, c, f, vfrom, efrom, vdata, i, ns, N, p, E, L, EF, EI, EN);
+    if (D) pagerankNormalizeOmpU(r, N);
+    return l;
+  };
+}
+
+
+
+
 // PAGERANK-CALCULATE
 // ------------------
 // For rank calculation from in-edges.
@@ -113,10 +171,12 @@ PagerankResult<T> pagerankOmp(const H& xt, const J& ks, size_t i, const M& ns, F
   T    E  = o.tolerance;
   int  L  = o.maxIterations, l = 0;
   int  EF = o.toleranceNorm;
-  auto vfrom = sourceOffsetsAs(xt, ks, K());
-  auto efrom = destinationIndicesAs(xt, ks, K());
-  auto vdata = vertexData(xt, ks);
-  vector<T> a(N), r(N), c(N), f(N), qc;
+  auto vfrom = sourceOffsetsAsOmp(xt, ks, K());
+  auto efrom = destinationIndicesAsOmp(xt, ks, vfrom);
+  auto vdata = vertexDataOmp(xt, ks);
+  auto a = createVectorOmp<T>(N), r = createVectorOmp<T>(N);  // first touch by owning threads
+  auto c = createVectorOmp<T>(N), f = createVectorOmp<T>(N);
+  vector<T> qc;
   if (q) qc = compressContainer(xt, *q, ks);
   float t = measureDuration([&]() {
     if (q) copyValuesOmpW(r, qc);  // copy old ranks (qc), if given
@@ -126,3 +186,30 @@ PagerankResult<T> pagerankOmp(const H& xt, const J& ks, size_t i, const M& ns, F
   }, o.repeat);
   return {decompressContainer(xt, r, ks), l, t};
 }
+
+
+// For Monolithic PageRank, upon a persistent CSR (vertices in CSR order).
+template <class H, class K, class M, class FL, class T=float>
+PagerankResult<T> pagerankOmp(const H& xt, const SlackCsr<K>& xc, K i, const M& ns, FL fl, const vector<T> *q, const PagerankOptions<T>& o) {
+  K    N  = xc.order();
+  K    S  = xc.span();  // includes null vertex
+  T    p  = o.damping;
+  T    E  = o.tolerance;
+  int  L  = o.maxIterations, l = 0;
+  int  EF = o.toleranceNorm;
+  const auto& ks    = xc.vertexKeys();
+  const auto& vfrom = xc.sourceOffsets();
+  const auto& efrom = xc.destinationIndices();
+  const auto& vdata = xc.vertexData();
+  auto a = createVectorOmp<T>(S), r = createVectorOmp<T>(S);  // first touch by owning threads
+  auto c = createVectorOmp<T>(S), f = createVectorOmp<T>(S);
+  vector<T> qc;
+  if (q) qc = compressContainer(xt, *q, ks);
+  float t = measureDuration([&]() {
+    if (q) copyValuesOmpW(r, qc);  // copy old ranks (qc), if given
+    else fillValueOmpU(r, 0, N, T(1)/N);
+    pagerankFactorOmpW(f, vdata, 0, N, p); multiplyValuesOmpW(c, r, f, 0, N);  // calculate factors (f) and contributions (c)
+    l = fl(a, r, c, f, vfrom, efrom, vdata, i, ns, N, p, E, L, EF, K(), K());  // calculate ranks of vertices
+  }, o.repeat);
+  return {decompressContainer(xt, r, ks), l, t};
+}
@@ -6,6 +6,7 @@
 #include "edges.hxx"
 #include "csr.hxx"
 #include "dynamic.hxx"
+#include "reorder.hxx"
 #include "pagerank.hxx"
 
 using std::vector;
@@ -16,24 +17,38 @@ using std::swap;
 
 // PAGERANK-VERTICES
 // -----------------
+// Vertices are reordered (o.reorder) only within components, so that
+// component/level groupings stay intact.
 
 template <class G, class H, class T>
 auto pagerankVertices(const G& x, const H& xt, const PagerankOptions<T>& o, const PagerankData<G> *D=nullptr) {
   using K = typename G::key_type;
-  if (!o.splitComponents) return vertexKeys(xt);
-  return joinValuesVector(componentsD(x, xt, D));
+  if (!o.splitComponents) {
+    auto ks = vertexKeys(xt);
+    reorderSlicesU(ks, vector<size_t> {ks.size()}, x, xt, o.reorder);
+    return ks;
+  }
+  const auto& cs = componentsD(x, xt, D);
+  auto ks = joinValuesVector(cs);
+  reorderSlicesU(ks, transformIterable(cs, [&](const auto& c) { return c.size(); }), x, xt, o.reorder);
+  return ks;
 }
 
 
 template <class G, class H, class T>
 auto pagerankDynamicVertices(const G& x, const H& xt, const G& y, const H& yt, const PagerankOptions<T>& o, const PagerankData<G> *D=nullptr) {
   using K = typename G::key_type;
-  if (!o.splitComponents) return dynamicInVertices(x, xt, y, yt);
+  if (!o.splitComponents) {
+    auto [ks, n] = dynamicInVerticesD(x, xt, y, yt, o, D);
+    reorderSlicesU(ks, vector<size_t> {size_t(n), ks.size()-n}, y, yt, o.reorder);
+    return make_pair(move(ks), n);
+  }
   const auto& cs = componentsD(y, yt, D);
   const auto& b  = blockgraphD(y, cs, D);
-  auto [is, n] = dynamicInComponentIndices(x, xt, y, yt, cs, b);
+  auto [is, n] = dynamicInComponentIndicesD(x, xt, y, yt, cs, b, o, D);
   auto ks = joinAtVector<K>(cs, sliceIterable(is, 0, n)); size_t nv = ks.size();
   joinAtU(ks, cs, sliceIterable(is, n));
+  reorderSlicesU(ks, transformIterable(is, [&](auto i) { return cs[i].size(); }), y, yt, o.reorder);
   return make_pair(ks, nv);
 }
 
@@ -51,11 +66,11 @@ auto pagerankComponents(const G& x, const H& xt, const PagerankOptions<T>& o, co
 }
 
 
-template <class G, class H>
-auto pagerankDynamicComponentsDefault(const G& x, const H& xt, const G& y, const H& yt) {
+template <class G, class H, class T>
+auto pagerankDynamicComponentsDefault(const G& x, const H& xt, const G& y, const H& yt, const PagerankOptions<T>& o, const PagerankData<G> *D=nullptr) {
   using K = typename G::key_type;
   vector2d<K> a;
-  auto [ks, n] = dynamicInVertices(x, xt, y, yt);
+  auto [ks, n] = dynamicInVerticesD(x, xt, y, yt, o, D);
   a.push_back(vector<K>(ks.begin(), ks.begin()+n));
   a.push_back(vector<K>(ks.begin()+n, ks.end()));
   return make_pair(a, size_t(1));
@@ -66,7 +81,7 @@ auto pagerankDynamicComponentsSplit(const G& x, const H& xt, const G& y, const H
   using K = typename G::key_type;
   const auto& cs = componentsD(y, yt, D);
   const auto& b  = blockgraphD(y, cs, D);
-  auto [is, n] = dynamicInComponentIndices(x, xt, y, yt, cs, b);
+  auto [is, n] = dynamicInComponentIndicesD(x, xt, y, yt, cs, b, o, D);
   vector2d<K> a;
   for (auto i : is)
     a.push_back(cs[i]);
@@ -76,7 +91,7 @@ auto pagerankDynamicComponentsSplit(const G& x, const H& xt, const G& y, const H
 template <class G, class H, class T>
 auto pagerankDynamicComponents(const G& x, const H& xt, const G& y, const H& yt, const PagerankOptions<T>& o, const PagerankData<G> *D=nullptr) {
   if (o.splitComponents) return pagerankDynamicComponentsSplit(x, xt, y, yt, o, D);
-  return pagerankDynamicComponentsDefault(x, xt, y, yt);
+  return pagerankDynamicComponentsDefault(x, xt, y, yt, o, D);
 }
 
 
@@ -110,6 +125,83 @@ T pagerankTeleport(const vector<T>& r, const vector<K>& vdata, K N, T p) {
 }
 
 
+// Sum of ranks of dead ends in [i, i+n) (teleport = (1-p)/N + p*sum/N, over all).
+template <class K, class T>
+T pagerankDeadEndSum(const vector<T>& r, const vector<K>& vdata, K i, K n) {
+  T a = T();
+  for (K u=i; u<i+n; u++)
+    if (vdata[u] == 0) a += r[u];
+  return a;
+}
+
+template <class K, class T>
+inline T pagerankTeleportFrom(T d, K N, T p) {
+  return (1-p)/N + p*d/N;
+}
+
+
+
+
+// PAGERANK-DEAD-ENDS
+// ------------------
+// With dead ends, every vertex gets the same teleport contribution (c), so
+// ranks are c*s, where s is the solution with a fixed teleport, i.e. s/sum(s).
+// A change in ranks of dead ends thus only scales all ranks uniformly. Ranks
+// can be found with teleport (1-p)/N, and normalized at the end; dynamic
+// pagerank then only updates vertices reachable from changed ones, provided
+// initial ranks are scaled to the same teleport.
+
+template <class K, class T>
+inline void pagerankNormalizeU(vector<T>& r, K N) {
+  T s = sumValues(r, 0, N);
+  if (s>0) multiplyValueW(r, r, 0, N, 1/s);
+}
+
+
+// Teleport contribution of initial ranks (q) on vertices of previous graph (x).
+// They need only be proportional to its ranks (see adjustRanks).
+template <class G, class T>
+T pagerankTeleportOf(const G& x, const vector<T>& q, T p) {
+  T a = T();
+  x.forEachVertexKey([&](auto u) { a += (isDeadEnd(x, u)? 1 : 1-p) * q[u]; });
+  return a / x.order();
+}
+
+// Teleport contribution of initial ranks (q) on vertices (ks) and dead ends (ds) of previous graph.
+template <class K, class T>
+T pagerankTeleportOf(const vector<K>& ks, const vector<K>& ds, const vector<T>& q, T p) {
+  T a = T();
+  for (K u : ks)
+    a += (1-p) * q[u];
+  for (K u : ds)
+    a += p * q[u];
+  return a / ks.size();
+}
+
+// Initial ranks, scaled to teleport (1-p)/N of updated graph (y), if dead ends are handled (D).
+// If the graph was updated in place (x = y), previous vertices and dead ends must be given (C).
+template <bool D, class G, class T>
+const vector<T>* pagerankDynamicInitialW(vector<T>& a, const G& x, const G& y, const vector<T> *q, T p, const PagerankData<G> *C=nullptr) {
+  bool old = C && C->verticesOld;
+  if (!D || !q || (old? C->verticesOld->empty() : x.order()==0)) return q;
+  T c = old? pagerankTeleportOf(*C->verticesOld, *C->deadEndsOld, *q, p) : pagerankTeleportOf(x, *q, p);  if (c<=0) return q;
+  a.resize(q->size());
+  multiplyValueW(a, *q, (1-p)/(y.order()*c));
+  return &a;
+}
+
+
+// Loop (fl) without dead-end handling, with ranks normalized after it (if D).
+template <bool D, class FL>
+inline auto pagerankNormalizedLoop(FL fl) {
+  return [fl](auto& a, auto& r, auto& c, const auto& f, const auto& vfrom, const auto& efrom, const auto& vdata, auto i, const auto& ns, auto N, auto p, auto E, int L, int EF, auto EI, auto EN) {
+    int l = fl(a, r, c, f, vfrom, efrom, vdata, i, ns, N, p, E, L, EF, EI, EN);
+    if (D) pagerankNormalizeU(r, N);
+    return l;
+  };
+}
+
+
 
 
 // PAGERANK-CALCULATE
@@ -134,6 +226,22 @@ void pagerankCalculateOrderedU(vector<T>& e, vector<T>& r, const vector<T>& f, c
 }
 
 
+// Also returns the sum of (updated) ranks of dead ends among them.
+template <class K, class T>
+T pagerankCalculateOrderedDeadEndsU(vector<T>& e, vector<T>& r, const vector<T>& f, const vector<K>& vfrom, const vector<K>& efrom, const vector<K>& vdata, K i, K n, T c0) {
+  T d = T();
+  for (K v=i; v<i+n; v++) {
+    T a = c0;
+    for (K u : sliceIterable(efrom, vfrom[v], vfrom[v+1]))
+      a += f[u] * r[u];
+    e[v] = a - r[v];
+    if (vdata[v] == 0) d += a;
+    r[v] = a;
+  }
+  return d;
+}
+
+
 
 
 // PAGERANK-ERROR
@@ -186,3 +294,28 @@ PagerankResult<T> pagerankSeq(const H& xt, const J& ks, size_t i, const M& ns, F
   }, o.repeat);
   return {decompressContainer(xt, r, ks), l, t};
 }
+
+
+// For Monolithic PageRank, upon a persistent CSR (vertices in CSR order).
+template <class H, class K, class M, class FL, class T=float>
+PagerankResult<T> pagerankSeq(const H& xt, const SlackCsr<K>& xc, K i, const M& ns, FL fl, const vector<T> *q, const PagerankOptions<T>& o) {
+  K    N  = xc.order();
+  K    S  = xc.span();  // includes null vertex
+  T    p  = o.damping;
+  T    E  = o.tolerance;
+  int  L  = o.maxIterations, l = 0;
+  int  EF = o.toleranceNorm;
+  const auto& ks    = xc.vertexKeys();
+  const auto& vfrom = xc.sourceOffsets();
+  const auto& efrom = xc.destinationIndices();
+  const auto& vdata = xc.vertexData();
+  vector<T> a(S), r(S), c(S), f(S), qc;
+  if (q) qc = compressContainer(xt, *q, ks);
+  float t = measureDuration([&]() {
+    if (q) copyValuesW(r, qc);   // copy old ranks (qc), if given
+    else fillValueU(r, 0, N, T(1)/N);
+    pagerankFactorW(f, vdata, 0, N, p); multiplyValuesW(c, r, f, 0, N);           // calculate factors (f) and contributions (c)
+    l = fl(a, r, c, f, vfrom, efrom, vdata, i, ns, N, p, E, L, EF, K(), K());     // calculate ranks of vertices
+  }, o.repeat);
+  return {decompressContainer(xt, r, ks), l, t};
+}
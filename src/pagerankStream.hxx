@@ -0,0 +1,552 @@
+#pragma once
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <deque>
+#include <utility>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <future>
+#include <condition_variable>
+#include <iostream>
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+#include "_main.hxx"
+#include "snap.hxx"
+#include "vertices.hxx"
+#include "deadEnds.hxx"
+#include "duplicate.hxx"
+#include "transpose.hxx"
+#include "dynamic.hxx"
+#include "pagerank.hxx"
+#include "pagerankSeq.hxx"
+#include "pagerankMonolithicBarrierfreeOmp.hxx"
+
+using std::string;
+using std::vector;
+using std::deque;
+using std::pair;
+using std::move;
+using std::swap;
+using std::ref;
+using std::cref;
+using std::to_string;
+using std::min;
+using std::max;
+using std::sort_heap;
+using std::push_heap;
+using std::pop_heap;
+using std::atomic;
+using std::mutex;
+using std::lock_guard;
+using std::unique_lock;
+using std::condition_variable;
+using std::thread;
+using std::async;
+using std::launch;
+using std::cin;
+using std::getline;
+using std::this_thread::yield;
+using std::this_thread::sleep_for;
+using std::chrono::milliseconds;
+
+
+
+
+// PAGERANK-STREAM-METRICS
+// -----------------------
+
+struct PagerankStreamMetrics {
+  size_t batch    = 0;  // batches applied (same as version)
+  size_t edges    = 0;  // edges in batch (insertions and deletions, as read)
+  size_t affected = 0;  // vertices whose ranks were recomputed
+  size_t queued   = 0;  // batches waiting, when ranks were published
+  int    iterations  = 0;
+  float  prepareTime = 0;  // apply batch, and find affected vertices (ms)
+  float  computeTime = 0;  // adjust ranks, and find pagerank (ms)
+  float  latency     = 0;  // batch closed, till its ranks are published (ms)
+  float  staleness   = 0;  // first edge of batch read, till its ranks are published (ms)
+};
+
+
+inline string pagerankStreamMetricsString(const PagerankStreamMetrics& m) {
+  char s[256];
+  snprintf(s, sizeof(s), "[%zu batch; %zu edges; %zu affected; %03d iters.] [%.3f ms prepare; %.3f ms compute; %.3f ms latency; %.3f ms staleness; %zu queued]",
+    m.batch, m.edges, m.affected, m.iterations, m.prepareTime, m.computeTime, m.latency, m.staleness, m.queued);
+  return s;
+}
+
+
+
+
+// RANK-SNAPSHOTS
+// --------------
+// Ranks are published to a pair of buffers. The writer (one) fills the back
+// buffer and then flips it to front, while readers (many) only pin the front
+// buffer they read (no locks). The writer waits for the back buffer only if
+// a reader is still at it, from two versions ago.
+
+template <class T>
+struct RankSnapshot {
+  size_t    version = 0;
+  vector<T> ranks;
+  PagerankStreamMetrics metrics;
+};
+
+
+template <class T>
+class RankSnapshots {
+  // Data.
+  protected:
+  RankSnapshot<T> slots[2];
+  atomic<int> front;
+  mutable atomic<int> readers[2];
+  atomic<size_t> latest;
+  atomic<bool>   finished;
+
+
+  // Property operations.
+  public:
+  inline size_t version()  const noexcept { return latest.load(); }
+  inline bool isFinished() const noexcept { return finished.load(); }
+
+
+  // Read operations.
+  public:
+  // Read current snapshot, with fn(snapshot).
+  template <class F>
+  auto read(F fn) const {
+    while (true) {
+      int i = front.load();
+      ++readers[i];
+      if (front.load()==i) {
+        auto a = fn(slots[i]);
+        --readers[i];
+        return a;
+      }
+      --readers[i];
+    }
+  }
+
+  // Current snapshot (only for the writer).
+  inline const RankSnapshot<T>& current() const noexcept {
+    return slots[front.load()];
+  }
+
+
+  // Update operations.
+  public:
+  // Fill back buffer with fn(snapshot), and make it current.
+  template <class F>
+  void write(F fn) {
+    int b = 1 - front.load();
+    while (readers[b].load()>0) yield();
+    fn(slots[b]);
+    front.store(b);
+    latest.store(slots[b].version);
+  }
+
+  // No more snapshots will be written.
+  inline void finish() noexcept { finished.store(true); }
+
+
+  // Lifetime operations.
+  public:
+  RankSnapshots() : front(0), latest(0), finished(false) {
+    readers[0] = 0;
+    readers[1] = 0;
+  }
+};
+
+
+
+
+// TOP-RANKS
+// ---------
+// Vertices with the k highest ranks, in descending order.
+
+template <class K, class T>
+auto topRanks(const vector<T>& r, size_t k) {
+  vector<pair<T, K>> a;
+  if (k==0) return a;
+  auto fl = [](const auto& p, const auto& q) { return p.first > q.first; };
+  for (size_t u=0; u<r.size(); ++u) {
+    if (a.size()<k) { a.push_back({r[u], K(u)}); push_heap(a.begin(), a.end(), fl); }
+    else if (r[u] > a[0].first) {
+      pop_heap(a.begin(), a.end(), fl);
+      a.back() = {r[u], K(u)};
+      push_heap(a.begin(), a.end(), fl);
+    }
+  }
+  sort_heap(a.begin(), a.end(), fl);
+  return a;
+}
+
+
+
+
+// EDGE-BATCH-QUEUE
+// ----------------
+// Edges are collected into a batch, which is closed when full, when asked
+// (commit), or when its first edge has waited for too long (delay, if set).
+
+template <class K>
+struct EdgeBatch {
+  vector<pair<K, K>> del, ins;
+  decltype(timeNow()) first;   // first edge read
+  decltype(timeNow()) closed;  // batch closed
+  inline size_t size() const noexcept { return del.size() + ins.size(); }
+};
+
+
+template <class K>
+class EdgeBatchQueue {
+  // Data.
+  protected:
+  mutable mutex lock;
+  condition_variable cv;
+  EdgeBatch<K> open;          // batch being filled
+  deque<EdgeBatch<K>> ready;  // closed batches, in order
+  size_t capacity;            // edges per batch
+  float  delay;               // close batch after (ms, 0 = never)
+  bool   ended = false;
+
+
+  // Close open batch (lock held).
+  protected:
+  void flushLocked() {
+    if (open.size()==0) return;
+    open.closed = timeNow();
+    ready.push_back(move(open));
+    open = EdgeBatch<K>();
+    cv.notify_all();
+  }
+
+
+  // Property operations.
+  public:
+  size_t size() const {
+    lock_guard<mutex> g(lock);
+    return ready.size();
+  }
+
+
+  // Update operations.
+  public:
+  void addEdge(K u, K v, bool remove=false) {
+    lock_guard<mutex> g(lock);
+    if (ended) return;
+    if (open.size()==0) { open.first = timeNow(); cv.notify_all(); }
+    if (remove) open.del.push_back({u, v});
+    else open.ins.push_back({u, v});
+    if (open.size()>=capacity) flushLocked();
+  }
+
+  void flush() {
+    lock_guard<mutex> g(lock);
+    flushLocked();
+  }
+
+  // No more edges (open batch is closed).
+  void end() {
+    lock_guard<mutex> g(lock);
+    flushLocked();
+    ended = true;
+    cv.notify_all();
+  }
+
+  // Wait for a closed batch (false if ended, and none left).
+  bool pop(EdgeBatch<K>& a) {
+    unique_lock<mutex> g(lock);
+    while (ready.empty() && !ended) {
+      if (delay<=0 || open.size()==0) { cv.wait(g); continue; }
+      float t = durationMilliseconds(open.first, timeNow());
+      if (t>=delay) flushLocked();
+      else cv.wait_for(g, microseconds(long((delay-t)*1000)+1));
+    }
+    if (ready.empty()) return false;
+    a = move(ready.front());
+    ready.pop_front();
+    return true;
+  }
+
+
+  // Lifetime operations.
+  public:
+  EdgeBatchQueue(size_t capacity, float delay=0) :
+  capacity(max(capacity, size_t(1))), delay(delay) {}
+};
+
+
+
+
+// PAGERANK-STREAM
+// ---------------
+// Batches are applied to a spare graph, and their affected vertices found
+// (prepare), on another thread while ranks of the previous batch are being
+// computed with barrier-free dynamic pagerank. Both only read the graph of
+// the previous batch. The spare graph is that of the batch before, and is
+// brought up to date by replaying the previous batch upon it (double
+// buffering), so that the graph is copied only once.
+
+template <class G, class H>
+struct PagerankStreamStage {
+  using K = typename G::key_type;
+  G y; H yt;
+  vector<pair<K, K>> del, ins;  // batch, as applied (reduced)
+  vector<K> ksOld, ks;  // vertex keys, before and after batch
+  vector<K> deadOld;    // dead ends, before batch
+  vector<K> vs; K n=0;  // affected vertices first (vs[0..n))
+  size_t edges = 0;
+  decltype(timeNow()) first, closed;
+  float prepareTime = 0;
+};
+
+
+// Stage (a) must hold the graph before previous stage (p), whose batch is
+// replayed upon it to get the graph (x) of previous stage, before the next
+// batch is applied. Work is thus O(batch) for the graph, not O(N+M).
+template <class G, class H, class K, class T>
+bool pagerankStreamPrepareW(PagerankStreamStage<G, H>& a, const PagerankStreamStage<G, H>& p, const G& x, const H& xt, EdgeBatchQueue<K>& q, const PagerankOptions<T>& o) {
+  EdgeBatch<K> b;
+  if (!q.pop(b)) return false;
+  a.edges  = b.size();
+  a.first  = b.first;
+  a.closed = b.closed;
+  a.prepareTime = measureDuration([&]() {
+    auto pdel = p.del, pins = p.ins;
+    applyBatchU(a.y, a.yt, pdel, pins);
+    a.del = move(b.del);
+    a.ins = move(b.ins);
+    auto kc = applyBatchU(a.y, a.yt, a.del, a.ins);
+    PagerankData<G> D; D.changed = &kc;
+    auto [vs, n] = pagerankDynamicVertices(x, xt, a.y, a.yt, o, &D);
+    a.vs = move(vs); a.n = K(n);
+    a.ksOld = vertexKeys(x);
+    a.deadOld = deadEnds(x);
+    a.ks    = vertexKeys(a.y);
+  });
+  return true;
+}
+
+
+// Publish ranks of original graph, as version 0.
+template <class G, class H, class T>
+void pagerankStreamInitialOmp(const G& x, const H& xt, RankSnapshots<T>& s, const PagerankOptions<T>& o) {
+  auto a = pagerankMonolithicBarrierfreeOmp<true, true, true>(x, xt, (const vector<T>*) nullptr, o);
+  PagerankStreamMetrics m;
+  m.affected   = size_t(x.order());
+  m.iterations = a.iterations;
+  m.computeTime = a.time;
+  s.write([&](auto& b) { b.version = 0; b.ranks = move(a.ranks); b.metrics = m; });
+}
+
+
+// Find pagerank of each batch in queue, until it ends.
+// @param x  original graph (updated to last batch)
+// @param xt transpose graph (with vertex-data=out-degree)
+// @param q  queue of edge batches
+// @param s  published ranks (version 0 must be of original graph)
+// @param o  options {damping=0.85, tolerance=1e-6, maxIterations=500}
+// @param PT threads for preparing a batch
+// @param fm called with metrics of each batch, once published
+template <class G, class H, class K, class T, class FM>
+void pagerankStreamOmp(G& x, H& xt, EdgeBatchQueue<K>& q, RankSnapshots<T>& s, const PagerankOptions<T>& o, int PT, FM fm) {
+  using S = PagerankStreamStage<G, H>;
+  auto prepare = [&](S& a, const S& p) {
+    omp_set_num_threads(PT);
+    return pagerankStreamPrepareW(a, p, p.y, p.yt, q, o);
+  };
+  // Stage being computed (c), and next one (d), which holds the spare graph.
+  S c, d; vector<T> r;
+  c.y  = duplicate(x);  d.y  = move(x);
+  c.yt = duplicate(xt); d.yt = move(xt);
+  bool ok = pagerankStreamPrepareW(c, d, d.y, d.yt, q, o);
+  for (size_t v=1; ok; ++v) {
+    // Prepare next batch, while this one is computed.
+    auto fd = async(launch::async, prepare, ref(d), cref(c));
+    PagerankResult<T> a({});
+    float t = measureDuration([&]() {
+      // Old ranks are scaled to teleport (1-p)/Y, if any vertex is to be updated.
+      const auto& rp = s.current().ranks;
+      size_t X = c.ksOld.size(), Y = c.ks.size();
+      T d = T(), p = o.damping;
+      for (K u : c.deadOld)
+        d += rp[u];
+      T rmul = c.n>0 && X>0? (1-p)/(Y * pagerankTeleportFrom(d, X, p)) : T(X)/Y;
+      r.assign(c.yt.span(), T());
+      if (Y>0) adjustRanksOmp(r, rp, c.ksOld, c.ks, T(), rmul, T(1)/Y);
+      a = pagerankMonolithicBarrierfreeOmpDynamic<true, true, true>(c.yt, c.vs, c.n, &r, o);
+    });
+    PagerankStreamMetrics m;
+    m.batch = v; m.edges = c.edges; m.affected = size_t(c.n); m.queued = q.size();
+    m.iterations  = a.iterations;
+    m.prepareTime = c.prepareTime;
+    m.computeTime = t;
+    auto now = timeNow();
+    m.latency   = durationMilliseconds(c.closed, now);
+    m.staleness = durationMilliseconds(c.first, now);
+    s.write([&](auto& b) { b.version = v; b.ranks = move(a.ranks); b.metrics = m; });
+    fm(m);
+    ok = fd.get();
+    if (ok) swap(c, d);  // graph of this batch is the spare one now
+  }
+  x  = move(c.y);
+  xt = move(c.yt);
+  s.finish();
+}
+
+
+
+
+// PAGERANK-STREAM-PROTOCOL
+// ------------------------
+// Line based, on stdin/stdout or a Unix socket:
+//   u v [t]   add edge (also "+ u v")
+//   - u v     remove edge
+//   commit    close batch (also a blank line)
+//   rank u    rank of vertex u     ->  "<u> <rank> <version>"
+//   top k     vertices of top rank ->  "<version> <u>:<rank> ..."
+//   stats     metrics of last batch
+//   wait v    wait till version v is published
+//   end       end input (pending batches are still processed)
+
+template <class K, class T, class FR>
+bool pagerankStreamLine(const string& ln, EdgeBatchQueue<K>& q, const RankSnapshots<T>& s, FR fr) {
+  const char *p = ln.c_str(), *e = p + ln.size();
+  while (p<e && (*p==' ' || *p=='\t' || *p=='\r')) ++p;
+  auto isCommand = [&](const char *c) {
+    size_t n = strlen(c);
+    if (size_t(e-p)<n || strncmp(p, c, n)!=0) return false;
+    if (p+n<e && p[n]!=' ' && p[n]!='\t' && p[n]!='\r') return false;
+    p += n;
+    return true;
+  };
+  if (p==e || isCommand("commit")) { q.flush(); return true; }
+  if (*p=='#' || *p=='%') return true;
+  if (isCommand("end")) { q.end(); return false; }
+  if (isCommand("stats")) {
+    fr(s.read([](const auto& b) { return pagerankStreamMetricsString(b.metrics); }));
+    return true;
+  }
+  size_t k = 0;
+  if (isCommand("rank")) {
+    if (!parseSnapInteger(k, p, e)) { fr("error: rank <vertex>"); return true; }
+    fr(s.read([&](const auto& b) {
+      char t[96];
+      snprintf(t, sizeof(t), "%zu %.6e %zu", k, k<b.ranks.size()? double(b.ranks[k]) : 0.0, b.version);
+      return string(t);
+    }));
+    return true;
+  }
+  if (isCommand("top")) {
+    if (!parseSnapInteger(k, p, e)) { fr("error: top <count>"); return true; }
+    fr(s.read([&](const auto& b) {
+      char t[64];
+      snprintf(t, sizeof(t), "%zu", b.version);
+      string a = t;
+      for (const auto& [r, u] : topRanks<K>(b.ranks, k)) {
+        snprintf(t, sizeof(t), " %zu:%.6e", size_t(u), double(r));
+        a += t;
+      }
+      return a;
+    }));
+    return true;
+  }
+  if (isCommand("wait")) {
+    if (!parseSnapInteger(k, p, e)) { fr("error: wait <version>"); return true; }
+    while (s.version()<k && !s.isFinished())
+      sleep_for(milliseconds(1));
+    fr(to_string(s.version()));
+    return true;
+  }
+  bool del = *p=='-';
+  if (del || *p=='+') ++p;
+  K u, v;
+  if (!parseSnapInteger(u, p, e) || !parseSnapInteger(v, p, e) || u<0 || v<0) { fr("error: bad line: " + ln); return true; }
+  q.addEdge(u, v, del);
+  return true;
+}
+
+
+// Serve stream protocol on stdin (replies on stdout), until end of input.
+template <class K, class T>
+void pagerankStreamStdin(EdgeBatchQueue<K>& q, const RankSnapshots<T>& s) {
+  string ln;
+  auto fr = [](const string& a) { printf("%s\n", a.c_str()); fflush(stdout); };
+  while (getline(cin, ln))
+    if (!pagerankStreamLine(ln, q, s, fr)) break;
+  q.end();
+}
+
+
+#ifdef __linux__
+// Serve stream protocol on a Unix socket (a thread per client), until a
+// client ends input.
+template <class K, class T>
+bool pagerankStreamSocket(const char *path, EdgeBatchQueue<K>& q, const RankSnapshots<T>& s) {
+  sockaddr_un sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sun_family = AF_UNIX;
+  if (strlen(path)>=sizeof(sa.sun_path)) { q.end(); return false; }
+  strcpy(sa.sun_path, path);
+  int sfd = socket(AF_UNIX, SOCK_STREAM, 0);
+  unlink(path);
+  if (sfd<0 || bind(sfd, (sockaddr*) &sa, sizeof(sa))<0 || listen(sfd, 16)<0) {
+    if (sfd>=0) close(sfd);
+    q.end();
+    return false;
+  }
+  mutex lock; vector<int> cfds; vector<thread> ths;
+  auto serve = [&](int cfd) {
+    auto fr = [&](const string& a) {
+      string b = a + "\n";
+      for (size_t i=0; i<b.size();) {
+        ssize_t n = send(cfd, b.data()+i, b.size()-i, MSG_NOSIGNAL);
+        if (n<=0) return;
+        i += size_t(n);
+      }
+    };
+    string buf; char t[65536];
+    while (true) {
+      ssize_t n = recv(cfd, t, sizeof(t), 0);
+      if (n<=0) break;
+      buf.append(t, size_t(n));
+      size_t i = 0, j;
+      for (; (j = buf.find('\n', i))!=string::npos; i=j+1) {
+        if (pagerankStreamLine(buf.substr(i, j-i), q, s, fr)) continue;
+        shutdown(sfd, SHUT_RDWR);  // wake accept
+        return;
+      }
+      buf.erase(0, i);
+    }
+    shutdown(cfd, SHUT_WR);  // let client see end of replies
+  };
+  while (true) {
+    int cfd = accept(sfd, nullptr, nullptr);
+    if (cfd<0) break;
+    lock_guard<mutex> g(lock);
+    cfds.push_back(cfd);
+    ths.emplace_back(serve, cfd);
+  }
+  q.end();
+  {
+    lock_guard<mutex> g(lock);
+    for (int cfd : cfds)
+      shutdown(cfd, SHUT_RDWR);
+  }
+  for (auto& th : ths)
+    th.join();
+  for (int cfd : cfds)
+    close(cfd);
+  close(sfd);
+  unlink(path);
+  return true;
+}
+#endif
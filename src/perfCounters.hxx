@@ -0,0 +1,134 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <omp.h>
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+using std::vector;
+
+
+
+
+// PERF-COUNTS
+// -----------
+// Hardware event counts, summed over threads (scaled if multiplexed).
+
+#define PERF_EVENTS 4
+
+struct PerfCounts {
+  bool     valid = false;
+  uint64_t cycles       = 0;
+  uint64_t instructions = 0;
+  uint64_t cacheMisses  = 0;
+  uint64_t branchMisses = 0;
+};
+
+
+
+
+// PERF-COUNTERS
+// -------------
+// Counters are opened (perf_event_open) by each OpenMP thread for itself,
+// as events of a thread are not inherited by threads that already exist.
+// The pool of OpenMP threads must be the same, from open() till close().
+
+class PerfCounters {
+  // Data.
+  protected:
+  vector<int> fds;  // PERF_EVENTS descriptors per thread
+
+
+  // Property operations.
+  public:
+  inline bool isOpen()  const noexcept { return !fds.empty(); }
+  inline int  threads() const noexcept { return int(fds.size()/PERF_EVENTS); }
+
+
+  // Update operations.
+  public:
+  // Open counters for each thread (false if not supported, or permitted).
+  bool open() {
+    close();
+#ifdef __linux__
+    const uint64_t cfg[PERF_EVENTS] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+    int  TS = omp_get_max_threads();
+    fds.assign(TS*PERF_EVENTS, -1);
+    #pragma omp parallel num_threads(TS)
+    {
+      int t = omp_get_thread_num();
+      for (int k=0; k<PERF_EVENTS; ++k) {
+        perf_event_attr e;
+        memset(&e, 0, sizeof(e));
+        e.size     = sizeof(e);
+        e.type     = PERF_TYPE_HARDWARE;
+        e.config   = cfg[k];
+        e.disabled = 1;
+        e.exclude_kernel = 1;
+        e.exclude_hv     = 1;
+        e.read_format    = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        fds[t*PERF_EVENTS + k] = int(syscall(__NR_perf_event_open, &e, 0, -1, -1, 0));
+      }
+    }
+    for (int fd : fds)
+      if (fd<0) { close(); return false; }
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  void close() {
+#ifdef __linux__
+    for (int fd : fds)
+      if (fd>=0) ::close(fd);
+#endif
+    fds.clear();
+  }
+
+  // Reset and enable all counters.
+  void start() {
+#ifdef __linux__
+    for (int fd : fds) {
+      ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+  }
+
+  // Disable all counters, and read their sum over threads.
+  PerfCounts stop() {
+    PerfCounts a;
+    if (!isOpen()) return a;
+#ifdef __linux__
+    uint64_t s[PERF_EVENTS] = {};
+    for (int fd : fds)
+      ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    for (size_t i=0; i<fds.size(); ++i) {
+      uint64_t b[3];  // value, time enabled, time running
+      if (read(fds[i], b, sizeof(b)) != ssize_t(sizeof(b))) return a;
+      double f = b[2]? double(b[1])/b[2] : 0;
+      s[i % PERF_EVENTS] += uint64_t(b[0] * f);
+    }
+    a.valid = true;
+    a.cycles       = s[0];
+    a.instructions = s[1];
+    a.cacheMisses  = s[2];
+    a.branchMisses = s[3];
+#endif
+    return a;
+  }
+
+
+  // Lifetime operations.
+  public:
+  PerfCounters() {}
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+  ~PerfCounters() { close(); }
+};
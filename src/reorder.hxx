@@ -0,0 +1,129 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include "_main.hxx"
+#include "vertices.hxx"
+
+using std::vector;
+using std::sort;
+using std::stable_sort;
+using std::stable_partition;
+using std::reverse;
+using std::copy;
+using std::min;
+
+
+
+
+// VERTEX-ORDER
+// ------------
+// Orderings of a slice of vertex keys, for locality of rank gathers.
+
+enum VertexOrder {
+  ORDER_NATURAL = 0,  // keep given order
+  ORDER_DEGREE  = 1,  // by out-degree, descending
+  ORDER_RCM     = 2,  // reverse Cuthill-McKee (BFS, over in- and out-edges)
+  ORDER_HUB     = 3   // hubs clustered first, in cache blocks
+};
+
+
+
+
+// DEGREE-ORDER
+// ------------
+// Vertices with more out-edges first (their ranks are gathered most often).
+
+template <class G, class K>
+void degreeOrderU(vector<K>& ks, size_t i, size_t n, const G& x) {
+  auto fl = [&](K u, K v) { return x.degree(u) > x.degree(v); };
+  stable_sort(ks.begin()+i, ks.begin()+i+n, fl);
+}
+
+
+
+
+// HUB-CLUSTER-ORDER
+// -----------------
+// Hubs (out-degree above average) are packed first, and the rest keep their
+// order. Hubs keep their order across blocks (of about L2-cache size), and
+// are sorted by out-degree within a block.
+
+#ifndef HUB_ORDER_BLOCK
+#define HUB_ORDER_BLOCK 16384
+#endif
+
+template <class G, class K>
+void hubClusterOrderU(vector<K>& ks, size_t i, size_t n, const G& x) {
+  if (n==0) return;
+  size_t M = 0;
+  for (size_t j=i; j<i+n; ++j)
+    M += x.degree(ks[j]);
+  auto ib = ks.begin()+i;
+  auto ih = stable_partition(ib, ib+n, [&](K u) { return x.degree(u)*n > M; });
+  auto fl = [&](K u, K v) { return x.degree(u) > x.degree(v); };
+  for (auto it=ib; it<ih; it+=min(ptrdiff_t(HUB_ORDER_BLOCK), ih-it))
+    stable_sort(it, it+min(ptrdiff_t(HUB_ORDER_BLOCK), ih-it), fl);
+}
+
+
+
+
+// RCM-ORDER
+// ---------
+// Reverse Cuthill-McKee, treating edges as undirected (x and its transpose).
+// BFS starts from vertices of least degree, and visits neighbours by degree.
+// Marks (vis, over span) must be zero, and are zero again upon return.
+
+template <class G, class H, class K>
+void rcmOrderU(vector<K>& ks, size_t i, size_t n, const G& x, const H& xt, vector<char>& vis) {
+  auto deg = [&](K u) { return x.degree(u) + xt.degree(u); };
+  auto fl  = [&](K u, K v) { return deg(u) < deg(v); };
+  vector<K> ss(ks.begin()+i, ks.begin()+i+n), a, ns;
+  stable_sort(ss.begin(), ss.end(), fl);
+  a.reserve(n);
+  for (K u : ss) vis[u] = 1;  // in slice
+  for (K s : ss) {
+    if (vis[s]!=1) continue;
+    vis[s] = 2; a.push_back(s);
+    for (size_t h=a.size()-1; h<a.size(); ++h) {
+      auto fe = [&](auto v) { if (vis[v]==1) { vis[v] = 2; ns.push_back(v); } };
+      ns.clear();
+      x.forEachEdgeKey(a[h], fe);
+      xt.forEachEdgeKey(a[h], fe);
+      stable_sort(ns.begin(), ns.end(), fl);
+      a.insert(a.end(), ns.begin(), ns.end());
+    }
+  }
+  for (K u : ss) vis[u] = 0;
+  reverse(a.begin(), a.end());
+  copy(a.begin(), a.end(), ks.begin()+i);
+}
+
+
+
+
+// REORDER
+// -------
+
+template <class G, class H, class K>
+void reorderU(vector<K>& ks, size_t i, size_t n, const G& x, const H& xt, int order, vector<char>& vis) {
+  switch (order) {
+    case ORDER_DEGREE: degreeOrderU(ks, i, n, x); break;
+    case ORDER_RCM:    rcmOrderU(ks, i, n, x, xt, vis); break;
+    case ORDER_HUB:    hubClusterOrderU(ks, i, n, x); break;
+    default: break;
+  }
+}
+
+
+// Reorder consecutive slices of given sizes (ns), each on its own.
+template <class G, class H, class K, class J>
+void reorderSlicesU(vector<K>& ks, const J& ns, const G& x, const H& xt, int order) {
+  if (order==ORDER_NATURAL) return;
+  auto vis = createContainer(x, char());
+  size_t i = 0;
+  for (auto n : ns) {
+    reorderU(ks, i, size_t(n), x, xt, order, vis);
+    i += size_t(n);
+  }
+}
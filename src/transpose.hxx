@@ -1,6 +1,16 @@
 #pragma once
+#include <utility>
+#include <algorithm>
+#include <vector>
+#include "_main.hxx"
 #include "Graph.hxx"
 
+using std::pair;
+using std::vector;
+using std::binary_search;
+using std::max;
+using std::swap;
+
 
 
 
@@ -44,3 +54,57 @@ auto transposeWithDegree(const G& x) {
   H a; transposeWithDegreeW(a, x, true);
   return a;
 }
+
+
+
+
+// APPLY-BATCH
+// -----------
+// Update graph and its transpose (with degree) in place, with a batch of
+// edge deletions and insertions (deletions are applied first). Batch lists
+// are reduced to the edges actually removed/added, and vertices touched by
+// them are returned (sorted). Only affected bitsets are updated, in parallel.
+
+template <class G, class H, class K>
+auto applyBatchU(G& x, H& xt, vector<pair<K, K>>& del, vector<pair<K, K>>& ins) {
+  vector<char> keep;
+  auto compact = [&](auto& es) {
+    size_t n = 0;
+    for (size_t i=0; i<es.size(); ++i)
+      if (keep[i]) es[n++] = es[i];
+    es.resize(n);
+  };
+  sortValues(del); del.resize(uniqueValues(del));
+  sortValues(ins); ins.resize(uniqueValues(ins));
+  // Drop edges that would not change the graph.
+  size_t D = del.size(), I = ins.size();
+  keep.resize(max(D, I));
+  #pragma omp parallel for schedule(static, 2048)
+  for (size_t i=0; i<D; ++i)
+    keep[i] = x.hasEdge(del[i].first, del[i].second);
+  compact(del);
+  #pragma omp parallel for schedule(static, 2048)
+  for (size_t i=0; i<I; ++i)
+    keep[i] = !x.hasEdge(ins[i].first, ins[i].second) || binary_search(del.begin(), del.end(), ins[i]);
+  compact(ins);
+  // Find touched vertices, and add new ones.
+  vector<K> ks;
+  for (const auto& [u, v] : del) { ks.push_back(u); ks.push_back(v); }
+  for (const auto& [u, v] : ins) { ks.push_back(u); ks.push_back(v); }
+  sortValues(ks); ks.resize(uniqueValues(ks));
+  for (K u : ks) {
+    x.addVertex(u);
+    xt.addVertex(u);
+  }
+  // Update out-edges, then in-edges.
+  x.updateEdges(del, ins);
+  auto tdel = del, tins = ins;
+  for (auto& [u, v] : tdel) swap(u, v);
+  for (auto& [u, v] : tins) swap(u, v);
+  sortValues(tdel); sortValues(tins);
+  xt.updateEdges(tdel, tins);
+  // Update out-degree (vertex value of transpose).
+  for (K u : ks)
+    xt.setVertexValue(u, x.degree(u));
+  return ks;
+}
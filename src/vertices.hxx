@@ -57,6 +57,19 @@ inline auto vertexData(const G& x) {
 }
 
 
+// Pages of data are first touched by the thread that owns them.
+template <class G, class J>
+auto vertexDataOmp(const G& x, const J& ks) {
+  using V = typename G::vertex_value_type;
+  auto a = createVectorOmp<V>(ks.size());
+  forEachSliceOmp(ks.size(), [&](size_t i, size_t I) {
+    for (size_t j=i; j<I; ++j)
+      a[j] = x.vertexValue(ks[j]);
+  });
+  return a;
+}
+
+
 
 
 // CREATE-CONTAINER